@@ -1,4 +0,0 @@
-/usr/local/bin/glslc shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
-/usr/local/bin/glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
-/usr/local/bin/glslc shaders/point_light.vert -o shaders/point_light.vert.spv
-/usr/local/bin/glslc shaders/point_light.frag -o shaders/point_light.frag.spv
\ No newline at end of file
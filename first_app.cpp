@@ -4,30 +4,36 @@
 #include "simple_render_system.hpp"
 #include "point_light_system.hpp"
 #include "lve_buffer.hpp"
+#include "lve_object_buffer.hpp"
 #include "baseTerrain.hpp"
+#include "lve_staging_ring.hpp"
+#include "lve_upload_batch.hpp"
+#include "lve_frame_pacer.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_frame_stats.hpp"
+#include "lve_profiler.hpp"
+#include "lve_secondary_recorder.hpp"
+#include "lve_indirect_buffer.hpp"
+#include "gpu_cull_system.hpp"
+#include "lve_depth_pyramid.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 
 
 
 namespace lve {
 
-    struct GlobalUbo{
-        glm::mat4 projection{1.f};
-        glm::mat4 view{1.f};
-        glm::vec4 ambientLightColor{1.f,1.f,1.f,0.02f}; //w is intensity
-        glm::vec3 lightPosition{-1.f};
-        alignas(32)glm::vec4 lightColor{1.f}; //w is light intensity
-        //vec4 lightColor -> (r,g,b,intensity) -> (rxi, gxi, bxi)
-        };
-
 FirstApp::FirstApp() {
+    LVE_PROFILE_THREAD("main");
     globalPool = LveDescriptorPool::Builder(lveDevice)
     .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
     .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
@@ -36,72 +42,266 @@ FirstApp::FirstApp() {
     //you can store different kinds of type but not the same type. You can set 2 uniform buffer descriptors together
 
     loadGameObjects();
-    std::cout<<"total game object size: "<< sizeof(gameObjects) << std::endl;
+    if (const char *recordThreads = std::getenv("LVE_RECORD_THREADS")) {
+        workerPool = std::make_unique<LveWorkerPool>(static_cast<uint32_t>(std::max(std::atoi(recordThreads), 0)));
+        std::cout << "recording on " << workerPool->getThreadCount() << " thread(s)" << std::endl;
+    }
+    std::cout<<"total entities: "<< world.size() << ", archetypes: " << world.getArchetypeCount() << std::endl;
 }
 
 FirstApp::~FirstApp() {
-   
+    // models defer freeing their mesh ranges, run those before meshPool is destroyed
+    world.clear();
+    vkDeviceWaitIdle(lveDevice.device());
+    lveDevice.deletionQueue().flushAll();
 }
 
-void FirstApp::run() {
-    std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-    
-    for(auto &uboBuffer:uboBuffers ){
-        uboBuffer = std::make_unique<LveBuffer>(
-            lveDevice,
-            sizeof(GlobalUbo),
-            1,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-        );
-        uboBuffer->map();
+bool FirstApp::updateRendererSettings(LveRendererSettings &settings) {
+    static constexpr VkPresentModeKHR presentModes[] = {
+        VK_PRESENT_MODE_FIFO_KHR,
+        VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_IMMEDIATE_KHR};
+    static constexpr float frameLimits[] = {0.f, 30.f, 60.f, 120.f, 144.f};
+
+    bool changed = false;
+    for (int i = 0; i < static_cast<int>(settingsKeysDown.size()); i++) {
+        bool down = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F1 + i) == GLFW_PRESS;
+        bool pressed = down && !settingsKeysDown[i];
+        settingsKeysDown[i] = down;
+        if (!pressed) continue;
+
+        if (i < 4) {
+            changed |= settings.framesInFlight != static_cast<uint32_t>(i + 1);
+            settings.framesInFlight = i + 1;
+        } else if (i < 8) {
+            changed |= settings.presentMode != presentModes[i - 4];
+            settings.presentMode = presentModes[i - 4];
+        } else if (i == 8) {
+            settings.lowLatency = !settings.lowLatency;
+            changed = true;
+        } else {
+            size_t next = 0;
+            for (size_t j = 0; j < std::size(frameLimits); j++) {
+                if (frameLimits[j] == settings.frameLimit) next = (j + 1) % std::size(frameLimits);
+            }
+            settings.frameLimit = frameLimits[next];
+            changed = true;
+        }
     }
+    return changed;
+}
 
+void FirstApp::run() {
     auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
     .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
     .build();
 
-    std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-    for(int i = 0; i<globalDescriptorSets.size(); i++){
-        auto bufferInfo = uboBuffers[i]->descriptorInfo();
-        LveDescriptorWriter(*globalSetLayout, *globalPool)
-        .writeBuffer(0, &bufferInfo)
-        .build(globalDescriptorSets[i]);
+    // model and normal matrices for every draw, one region per frame in flight
+    LveObjectBuffer objectBuffer{lveDevice, lveRenderer.getFramesInFlight()};
+    // timestamps per frame slot, read back when the slot is reused
+    LveGpuProfiler gpuProfiler{lveDevice, lveRenderer.getFramesInFlight()};
+    // draw commands for the whole scene, LVE_INDIRECT=0 records every draw on the cpu instead
+    std::unique_ptr<LveIndirectBuffer> indirectBuffer;
+    const char *indirectEnv = std::getenv("LVE_INDIRECT");
+    bool useIndirect = indirectEnv == nullptr || std::atoi(indirectEnv) != 0;
+    if (useIndirect && LveIndirectBuffer::isSupported(lveDevice)) {
+        indirectBuffer = std::make_unique<LveIndirectBuffer>(lveDevice, lveRenderer.getFramesInFlight());
+    }
+    // frustum and occlusion culling in a compute pass ahead of the indirect draws,
+    // LVE_GPU_CULL=0 draws every object
+    std::unique_ptr<GpuCullSystem> gpuCullSystem;
+    const char *cullEnv = std::getenv("LVE_GPU_CULL");
+    if (indirectBuffer && (cullEnv == nullptr || std::atoi(cullEnv) != 0)) {
+        gpuCullSystem = std::make_unique<GpuCullSystem>(lveDevice, objectBuffer.getDescriptorSetLayout(), lveRenderer.getFramesInFlight());
+    }
+    // two phase occlusion culling against a depth pyramid of this frame, LVE_OCCLUSION=0 keeps
+    // frustum culling only
+    std::unique_ptr<LveDepthPyramid> depthPyramid;
+    const char *occlusionEnv = std::getenv("LVE_OCCLUSION");
+    if (gpuCullSystem && (occlusionEnv == nullptr || std::atoi(occlusionEnv) != 0)) {
+        depthPyramid = std::make_unique<LveDepthPyramid>(lveDevice, lveRenderer.getFramesInFlight());
     }
-    
-    SimpleRenderSystem simpleRendereSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+    // a command pool per frame in flight and recording thread
+    std::unique_ptr<LveSecondaryRecorder> secondaryRecorder;
+    if (workerPool) {
+        secondaryRecorder = std::make_unique<LveSecondaryRecorder>(lveDevice, *workerPool, lveRenderer.getFramesInFlight());
+    }
+
+    // per frame containers follow the renderer's frames in flight and are rebuilt when it changes
+    std::vector<std::unique_ptr<LveBuffer>> uboBuffers;
+    std::vector<VkDescriptorSet> globalDescriptorSets;
+    auto createFrameResources = [&]() {
+        uint32_t frameCount = lveRenderer.getFramesInFlight();
+        globalPool->resetPool();
+        uboBuffers.clear();
+        uboBuffers.resize(frameCount);
+        globalDescriptorSets.assign(frameCount, VK_NULL_HANDLE);
+
+        for(int i = 0; i<uboBuffers.size(); i++){
+            uboBuffers[i] = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(GlobalUbo),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            );
+            uboBuffers[i]->map();
+
+            auto bufferInfo = uboBuffers[i]->descriptorInfo();
+            LveDescriptorWriter(*globalSetLayout, *globalPool)
+            .writeBuffer(0, &bufferInfo)
+            .build(globalDescriptorSets[i]);
+        }
+        objectBuffer.setFrameCount(frameCount);
+        gpuProfiler.setFrameCount(frameCount);
+        if (secondaryRecorder) secondaryRecorder->setFrameCount(frameCount);
+        if (indirectBuffer) indirectBuffer->setFrameCount(frameCount);
+        if (gpuCullSystem) gpuCullSystem->setFrameCount(frameCount);
+        if (depthPyramid) depthPyramid->setFrameCount(frameCount);
+    };
+    createFrameResources();
+
+    SimpleRenderSystem simpleRendereSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), objectBuffer.getDescriptorSetLayout()};
     PointLightSytem pointLightSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
     LveCamera camera {};
 
 
-    auto viewerObject = LveGameObject::createGameObject();
-    viewerObject.transform.translation.z = -2.5f;
+    // the viewer has no mesh, the render systems' queries never see it
+    TransformComponent viewerTransform{};
+    viewerTransform.setTranslation({0.f, 0.f, -2.5f});
+    LveEntity viewer = world.createEntity(std::move(viewerTransform), KeyboardControlComponent{});
     KeyboardMovementController cameraController{};
 
     std::cout << "max push conts size = " << lveDevice.properties.limits.maxPushConstantsSize << "\n";
 
 
+    LveFramePacer framePacer{};
+    // LVE_FRAME_STATS_CSV=path appends every frame's timings to a csv file
+    LveFrameStats frameStats{};
+    if (const char *csvPath = std::getenv("LVE_FRAME_STATS_CSV")) {
+        if (!frameStats.openCsv(csvPath)) {
+            std::cerr << "failed to open " << csvPath << std::endl;
+        }
+    }
+    float titleTimer = 0.f;
+    auto loopTime = std::chrono::steady_clock::now();
+    float frameTime = 0.f;
     auto currentTime = std::chrono::high_resolution_clock::now();
-    while (!lveWindow.shouldClose()) {
+    LveFramePacer::Clock::time_point inputSampledAt{};
+    // everything that depends on input, the camera ends up in this frame's ubo
+    auto sampleInput = [&]() {
+        LVE_PROFILE_SCOPE("input");
         // poll events checks if any events are triggered (like keyboard or mouse input)
         // or dismissed the window etc.
         glfwPollEvents();
+        inputSampledAt = LveFramePacer::Clock::now();
 
         auto newTime = std::chrono::high_resolution_clock::now();
-        float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime-currentTime).count();
+        frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime-currentTime).count();
         currentTime = newTime;
 
         frameTime = glm::min(frameTime, 0.1f);
 
-        cameraController.moveInPlanceXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
+        cameraController.moveInPlanceXZ(lveWindow.getGLFWwindow(), frameTime, world);
         //std::cout<<frameTime<<std::endl;
-        lveWindow.setWindowTitle("fps: " +std::to_string(1/frameTime));
-        camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+        const TransformComponent &viewerObject = *world.getComponent<TransformComponent>(viewer);
+        camera.setViewYXZ(viewerObject.getTranslation(), viewerObject.getRotation());
+        // keys at a fixed interval, the spline smooths out the jitter between them
+        if (recordingPath) {
+            if (pathTime >= nextPathKey) {
+                recordedPath.addKey(pathTime, viewerObject.getTranslation(), viewerObject.getRotation());
+                nextPathKey += PATH_KEY_INTERVAL;
+            }
+            pathTime += frameTime;
+        }
 
         float aspect = lveRenderer.getAspectRatio();
         //camera.setOrthographicProjection(-aspect,aspect,-1,1,-1,1);
         camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
-        if (auto commandBuffer = lveRenderer.beginFrame()){
+    };
+
+    while (!lveWindow.shouldClose()) {
+        // the previous frame is complete on the cpu side, its gpu time is the latest read back
+        auto newLoopTime = std::chrono::steady_clock::now();
+        LveFrameStats::Sample frameSample{};
+        frameSample.cpuFrameMs = std::chrono::duration<float, std::milli>(newLoopTime - loopTime).count();
+        frameSample.gpuMs = gpuProfiler.getLatestMs(LveGpuProfiler::FRAME_ZONE);
+        frameSample.fenceWaitMs = lveRenderer.getLastFrameWaits().fenceMs;
+        frameSample.acquireWaitMs = lveRenderer.getLastFrameWaits().acquireMs;
+        frameSample.presentWaitMs = lveRenderer.getLastFrameWaits().presentMs;
+        frameStats.record(frameSample);
+        loopTime = newLoopTime;
+
+        // key states are from the previous poll, settings can only change between frames
+        LveRendererSettings settings = lveRenderer.getSettings();
+        if (updateRendererSettings(settings)) {
+            // waits for the device, so the old per frame resources can go right away
+            lveRenderer.applySettings(settings);
+            createFrameResources();
+        }
+        bool traceKey = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F12) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown) {
+            if (LveProfiler::writeChromeTrace(TRACE_FILE)) {
+                std::cout << "cpu trace written to " << TRACE_FILE << std::endl;
+            } else {
+                std::cerr << "failed to write " << TRACE_FILE << std::endl;
+            }
+        }
+        traceKeyDown = traceKey;
+        bool pathKey = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F11) == GLFW_PRESS;
+        if (pathKey && !pathKeyDown) {
+            recordingPath = !recordingPath;
+            if (recordingPath) {
+                recordedPath.clear();
+                pathTime = 0.f;
+                nextPathKey = 0.f;
+                std::cout << "recording camera path" << std::endl;
+            } else if (recordedPath.saveToFile(CAMERA_PATH_FILE)) {
+                std::cout << "camera path with " << recordedPath.keyCount() << " keys written to " << CAMERA_PATH_FILE << std::endl;
+            } else {
+                std::cerr << "failed to write " << CAMERA_PATH_FILE << std::endl;
+            }
+        }
+        pathKeyDown = pathKey;
+
+        framePacer.setFrameLimit(settings.frameLimit);
+        {
+            LVE_PROFILE_SCOPE("frame limiter");
+            framePacer.waitForNextFrame();
+        }
+
+        // throughput: sample input first and let the cpu run ahead until the fence blocks it.
+        // low latency: block on the fence first, so the input is as fresh as possible when the
+        // frame is recorded right after. Both measure latency from when the input was read, which
+        // is handed to the pacer only after the slot's previous frame has been measured
+        int frameSlot = lveRenderer.getFrameSlot();
+        if (!settings.lowLatency) sampleInput();
+        lveRenderer.waitForFrameFence();
+        framePacer.markFrameCompleted(frameSlot);
+
+        auto commandBuffer = lveRenderer.beginFrame();
+        // no frame was begun when the swap chain was recreated, the slot's next frame stamps it
+        if (commandBuffer) {
+            // after the acquire, which can block as well with fifo
+            if (settings.lowLatency) sampleInput();
+            framePacer.markInputSampled(frameSlot, inputSampledAt);
+        }
+
+        // a single frame delta hides spikes, the title shows the window's median and 1% low
+        titleTimer += frameSample.cpuFrameMs / 1000.f;
+        if (titleTimer >= 0.5f) {
+            titleTimer = 0.f;
+            auto cpuSummary = frameStats.summarize(LveFrameStats::Metric::CpuFrame);
+            lveWindow.setWindowTitle("fps: " + std::to_string(1000.f / std::max(cpuSummary.p50Ms, 0.001f)) +
+                " (1% low " + std::to_string(cpuSummary.onePercentLowFps) + ") | frames in flight: " +
+                std::to_string(lveRenderer.getFramesInFlight()) + " | " +
+                LveRendererSettings::presentModeName(lveRenderer.getPresentMode()) +
+                (settings.lowLatency ? " | low latency" : "") + " | latency: " +
+                std::to_string(framePacer.getAverageLatencyMs()) + " ms | gpu: " +
+                std::to_string(gpuProfiler.getStats(LveGpuProfiler::FRAME_ZONE).averageMs) + " ms");
+        }
+        if (commandBuffer){
             int frameIndex = lveRenderer.getFrameIndex();
             FrameInfo frameInfo{
                 frameIndex,
@@ -109,66 +309,123 @@ void FirstApp::run() {
                 commandBuffer,
                 camera,
                 globalDescriptorSets[frameIndex],
-                gameObjects
+                world,
+                objectBuffer,
+                gpuProfiler,
+                secondaryRecorder.get(),
+                indirectBuffer.get()
             };
+            gpuProfiler.beginFrame(commandBuffer, frameIndex);
+            objectBuffer.beginFrame(frameIndex, static_cast<uint32_t>(world.size()));
 
             //update
-            GlobalUbo ubo{};
-            ubo.projection = camera.getProjection();
-            ubo.view = camera.getView();
-            uboBuffers[frameIndex]->writeToBuffer(&ubo);
-            uboBuffers[frameIndex]->flush();
+            {
+                LVE_PROFILE_SCOPE("ubo update");
+                GlobalUbo ubo{};
+                ubo.projection = camera.getProjection();
+                ubo.view = camera.getView();
+                pointLightSystem.update(frameInfo, ubo);
+                uboBuffers[frameIndex]->writeToBuffer(&ubo);
+                uboBuffers[frameIndex]->flush();
+            }
 
             //render
-            lveRenderer.beginSwapChainRenderPass(commandBuffer);
-            simpleRendereSystem.renderGameObjects(frameInfo);
-            pointLightSystem.render(frameInfo);
-            lveRenderer.endSwapChainRenderPass(commandBuffer);
+            {
+                LVE_PROFILE_SCOPE("record");
+                // compute work has to be recorded before the render pass begins
+                if (gpuCullSystem) simpleRendereSystem.cullGameObjects(frameInfo, *gpuCullSystem, depthPyramid != nullptr);
+                VkSubpassContents contents = secondaryRecorder ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+                lveRenderer.beginSwapChainRenderPass(commandBuffer, contents);
+                if (secondaryRecorder) {
+                    secondaryRecorder->beginFrame(frameIndex, lveRenderer.getRenderPassInheritance(), lveRenderer.getSwapChainExtent());
+                }
+                simpleRendereSystem.renderGameObjects(frameInfo);
+                if (depthPyramid) {
+                    // what was visible last frame is drawn, its depth occludes the rest
+                    if (secondaryRecorder) secondaryRecorder->execute(commandBuffer);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                    depthPyramid->build(commandBuffer, frameIndex, gpuProfiler, lveRenderer.getDepthImageView(), lveRenderer.getSwapChainExtent());
+                    HiZInput hiZ{};
+                    hiZ.view = depthPyramid->getView();
+                    hiZ.layout = depthPyramid->getLayout();
+                    hiZ.extent = depthPyramid->getExtent();
+                    hiZ.mipCount = depthPyramid->getMipCount();
+                    hiZ.viewProjection = camera.getProjection() * camera.getView();
+                    gpuCullSystem->setHiZ(hiZ);
+                    simpleRendereSystem.cullOccludedGameObjects(frameInfo, *gpuCullSystem);
+                    lveRenderer.resumeSwapChainRenderPass(commandBuffer, contents);
+                    simpleRendereSystem.renderOccludedGameObjects(frameInfo);
+                }
+                pointLightSystem.render(frameInfo);
+                if (secondaryRecorder) secondaryRecorder->execute(commandBuffer);
+                lveRenderer.endSwapChainRenderPass(commandBuffer);
+                gpuProfiler.endFrame(commandBuffer);
+            }
             lveRenderer.endFrame();
         }
+    }
 
-        vkDeviceWaitIdle(lveDevice.device());
+    // the per frame resources below are destroyed when run() returns
+    vkDeviceWaitIdle(lveDevice.device());
+    if (gpuProfiler.isSupported()) {
+        std::cout << "gpu timings over the last " << LveGpuProfiler::HISTORY_SIZE << " frames:\n"
+                  << gpuProfiler.report();
     }
 }
 
 void FirstApp::loadGameObjects() {
-
+    LVE_PROFILE_FUNCTION();
+    // every model upload is recorded into this batch and submitted once at the end
+    LveUploadBatch uploadBatch{lveDevice};
+    // static meshes share a few large buffers so draws need no per object binds
+    meshPool = std::make_unique<LveMeshPool>(lveDevice, sizeof(LveModel::Vertex));
 
     BaseTerrain terrain("./data/heightmap.save");
-    std::shared_ptr<LveModel> terrainModel = LveModel::loadHeightMap(lveDevice, terrain.terrainData);
+    std::shared_ptr<LveModel> terrainModel = LveModel::loadHeightMap(lveDevice, terrain.terrainData, &uploadBatch, meshPool.get());
 
-    auto terrainObject = LveGameObject::createGameObject();
-    terrainObject.model = terrainModel;
-    terrainObject.transform.scale = {0.03f,0.01f,0.03f};
-    terrainObject.transform.translation = {-5.f, -0.5f, -5.f};
-    gameObjects.emplace(terrainObject.getId(), std::move(terrainObject));
+    TransformComponent terrainTransform{};
+    terrainTransform.setScale({0.03f,0.01f,0.03f});
+    terrainTransform.setTranslation({-5.f, -0.5f, -5.f});
+    terrainTransform.setStatic(true);
+    world.createEntity(std::move(terrainTransform), MeshComponent{terrainModel});
 
 
 
-    std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "./models/smooth_vase.obj");
-    auto gameObject1 = LveGameObject::createGameObject();
-    gameObject1.model = lveModel;
-    gameObject1.transform.translation = {0.f, .5f, 1.f};
-    gameObject1.transform.scale = {2.f, 2.f, 2.f};
-    gameObjects.emplace(gameObject1.getId(), std::move(gameObject1));
+    std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "./models/smooth_vase.obj", &uploadBatch, meshPool.get());
+    TransformComponent transform1{};
+    transform1.setTranslation({0.f, .5f, 1.f});
+    transform1.setScale({2.f, 2.f, 2.f});
+    transform1.setStatic(true);
+    world.createEntity(std::move(transform1), MeshComponent{lveModel});
 
-    auto gameObject2 = LveGameObject::createGameObject();
-    gameObject2.model = lveModel;
-    gameObject2.transform.translation = {0.f, .5f, 0.f};
-    gameObject2.transform.scale = {2.f, 2.f, 2.f};
-    gameObjects.emplace(gameObject2.getId(), std::move(gameObject2));
+    TransformComponent transform2{};
+    transform2.setTranslation({0.f, .5f, 0.f});
+    transform2.setScale({2.f, 2.f, 2.f});
+    transform2.setStatic(true);
+    world.createEntity(std::move(transform2), MeshComponent{lveModel});
     //reason of this tranform:
     //x from [-1, 1], y from [-1, 1] but z from [0, 1]
     //because the z value is form 0 to 1 front half to he object will be cliped since it is bigger than viewing volume
     //so we move it on z axis then scale it by half
 
     /*std::shared_ptr<LveModel> quadModel = LveModel::createModelFromFile(lveDevice, "./models/quad.obj");
-    auto quad_floor = LveGameObject::createGameObject();
-    quad_floor.model = quadModel;
-    quad_floor.transform.translation = {0.f, .5f, 0.f};
-    quad_floor.transform.scale = {3.f, 1.f, 3.f};
-    gameObjects.emplace(quad_floor.getId(), std::move(quad_floor));*/
-
+    TransformComponent quadTransform{};
+    quadTransform.setTranslation({0.f, .5f, 0.f});
+    quadTransform.setScale({3.f, 1.f, 3.f});
+    world.createEntity(std::move(quadTransform), MeshComponent{quadModel});*/
+
+    // the scene used to have a single white light at (-1, -1, -1) baked into the ubo
+    createPointLight(world, {-1.f, -1.f, -1.f}, 1.f);
+
+    uploadBatch.submitAndWait();
+    std::cout << "uploaded " << uploadBatch.getUploadCount() << " buffers in "
+              << uploadBatch.getSubmitCount() << " submit(s), staging peak "
+              << lveDevice.stagingRing().getPeakBytesInFlight() / 1024 << " KiB" << std::endl;
+    auto memoryStats = lveDevice.allocator().getStats();
+    std::cout << memoryStats.allocationCount << " allocations in " << memoryStats.blockCount
+              << " block(s) + " << memoryStats.dedicatedCount << " dedicated, "
+              << memoryStats.usedBytes / (1024 * 1024) << " / "
+              << memoryStats.reservedBytes / (1024 * 1024) << " MiB used" << std::endl;
 }
 
 } // namespace lve
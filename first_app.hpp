@@ -5,7 +5,11 @@
 #include "lve_window.hpp"
 #include "lve_renderer.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_camera_path.hpp"
+#include "lve_worker_pool.hpp"
 
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -24,14 +28,34 @@ namespace lve {
     private:
 
         void loadGameObjects();
+        // F1-F4 select frames in flight, F5-F8 the present mode, F9 toggles low latency pacing and
+        // F10 cycles the frame limit, returns true on change
+        bool updateRendererSettings(LveRendererSettings &settings);
 
         LveWindow lveWindow{WIDTH, HEIGHT, "Hello Vulkan!"};
         LveDevice lveDevice{lveWindow};
-        LveRenderer lveRenderer {lveWindow, lveDevice};
+        LveRenderer lveRenderer {lveWindow, lveDevice, LveRendererSettings::fromEnvironment()};
 
         //order of declarations matter of these
         std::unique_ptr<LveDescriptorPool> globalPool{}; 
-        LveGameObject::Map gameObjects;
+        std::unique_ptr<LveMeshPool> meshPool{}; // must outlive the models in world
+        LveWorld world;
+        // LVE_RECORD_THREADS=n records draws into secondary command buffers on n threads, unset
+        // records inline on the main thread
+        std::unique_ptr<LveWorkerPool> workerPool{};
+
+        std::array<bool, 10> settingsKeysDown{};
+        // F12 writes the cpu profiler's zones to TRACE_FILE
+        bool traceKeyDown = false;
+        static constexpr const char *TRACE_FILE = "lve_trace.json";
+        // F11 starts and stops recording the camera into CAMERA_PATH_FILE, for lve_bench --path
+        bool pathKeyDown = false;
+        bool recordingPath = false;
+        float pathTime = 0.f;
+        float nextPathKey = 0.f;
+        LveCameraPath recordedPath;
+        static constexpr float PATH_KEY_INTERVAL = 0.25f;
+        static constexpr const char *CAMERA_PATH_FILE = "camera_path.txt";
     
     };
 }
\ No newline at end of file
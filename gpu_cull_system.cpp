@@ -0,0 +1,368 @@
+#include "gpu_cull_system.hpp"
+#include "lve_profiler.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace lve {
+
+GpuCullSystem::GpuCullSystem(LveDevice& device, VkDescriptorSetLayout objectSetLayout, uint32_t frameCount) : lveDevice{device} {
+    cullSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .build();
+    // two sets per frame, one for the early (or single) pass and one for the late pass
+    descriptorPool = LveDescriptorPool::Builder(lveDevice)
+        .setMaxSets(2 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+        .build();
+
+    createPipelineLayout(objectSetLayout);
+    computePipeline = std::make_unique<LveComputePipeline>(lveDevice, "shaders/cull.comp.spv", pipelineLayout);
+    createHiZPlaceholder();
+    createFrames(frameCount);
+}
+
+GpuCullSystem::~GpuCullSystem() {
+    vkDestroySampler(lveDevice.device(), hiZSampler, nullptr);
+    vkDestroyImageView(lveDevice.device(), placeholderView, nullptr);
+    vkDestroyImage(lveDevice.device(), placeholderImage, nullptr);
+    lveDevice.allocator().free(placeholderMemory);
+    vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+}
+
+void GpuCullSystem::createPipelineLayout(VkDescriptorSetLayout objectSetLayout) {
+    // the object buffer keeps set 1 like in the graphics pipelines
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{cullSetLayout->getDescriptorSetLayout(), objectSetLayout};
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull pipeline layout");
+    }
+}
+
+void GpuCullSystem::createHiZPlaceholder() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.minLod = 0.f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &hiZSampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create hi-z sampler");
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {1, 1, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, placeholderImage, placeholderMemory);
+
+    VkImageSubresourceRange range{};
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = placeholderImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange = range;
+    if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &placeholderView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create hi-z placeholder view");
+    }
+
+    // once at startup, a stall is fine here
+    VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = placeholderImage;
+    barrier.subresourceRange = range;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkClearColorValue farDepth{};
+    farDepth.float32[0] = 1.f;
+    vkCmdClearColorImage(commandBuffer, placeholderImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farDepth, 1, &range);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    lveDevice.endSingleTimeCommands(commandBuffer);
+}
+
+void GpuCullSystem::createFrames(uint32_t frameCount) {
+    descriptorPool->resetPool();
+    frames.clear();
+    frames.resize(frameCount);
+    for (auto &frame: frames) {
+        frame.uniformBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            sizeof(CullUbo),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        frame.uniformBuffer->map();
+        createDrawBuffer(frame, 64);
+    }
+    currentFrame = 0;
+    drawCount = 0;
+}
+
+void GpuCullSystem::createDrawBuffer(Frame& frame, uint32_t capacity) {
+    // only this frame slot reads it and its fence was waited on, no need for the deletion queue
+    frame.drawBuffer = std::make_unique<LveBuffer>(
+        lveDevice,
+        sizeof(CullDraw),
+        capacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    frame.drawBuffer->map();
+    frame.drawCapacity = capacity;
+}
+
+void GpuCullSystem::setFrameCount(uint32_t count) {
+    if (count == frames.size()) return;
+    createFrames(count);
+}
+
+void GpuCullSystem::beginFrame(int frameIndex, uint32_t drawCount, uint32_t visibilityCount) {
+    assert(frameIndex >= 0 && static_cast<size_t>(frameIndex) < frames.size() && "Frame index out of range");
+    auto &frame = frames[frameIndex];
+    if (drawCount > frame.drawCapacity) {
+        createDrawBuffer(frame, std::max(drawCount, frame.drawCapacity * 2));
+    }
+    currentFrame = frameIndex;
+    this->drawCount = 0;
+    this->visibilityCount = std::max(visibilityCount, 1u);
+}
+
+void GpuCullSystem::prepareVisibility(VkCommandBuffer commandBuffer) {
+    if (visibilityCount > visibilityCapacity) {
+        if (visibilityBuffer) {
+            // frames in flight still read and write the old one
+            std::shared_ptr<LveBuffer> oldVisibility = std::move(visibilityBuffer);
+            lveDevice.deletionQueue().push([oldVisibility]() {});
+        }
+        visibilityCapacity = std::max(visibilityCount, visibilityCapacity * 2);
+        visibilityBuffer = std::make_unique<LveBuffer>(
+            lveDevice,
+            sizeof(uint32_t),
+            visibilityCapacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        vkCmdFillBuffer(commandBuffer, visibilityBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        visibilityResets.clear();
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+        );
+        return;
+    }
+
+    // the late pass of the previous frame wrote what the early pass reads
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    if (visibilityResets.empty()) {
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+        );
+        return;
+    }
+
+    // the fills must not race the late pass of the previous frame either
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+    for (uint32_t index : visibilityResets) {
+        vkCmdFillBuffer(commandBuffer, visibilityBuffer->getBuffer(), index * sizeof(uint32_t), sizeof(uint32_t), 0);
+    }
+    visibilityResets.clear();
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+}
+
+void GpuCullSystem::resetVisibility(uint32_t visibilityIndex) {
+    assert(visibilityIndex < visibilityCount && "Visibility index out of range, pass the count to beginFrame");
+    visibilityResets.push_back(visibilityIndex);
+}
+
+uint32_t GpuCullSystem::addDraw(const CullDraw& draw) {
+    auto &frame = frames[currentFrame];
+    assert(drawCount < frame.drawCapacity && "Cull draw table overflow, pass the draw count to beginFrame");
+    CullDraw entry = draw;
+    frame.drawBuffer->writeToIndex(&entry, static_cast<int>(drawCount));
+    return drawCount++;
+}
+
+void GpuCullSystem::setHiZ(const HiZInput& input) {
+    hiZ = input;
+}
+
+void GpuCullSystem::clearHiZ() {
+    hiZ = HiZInput{};
+}
+
+void GpuCullSystem::updateDescriptorSet(CullSet& set, Frame& frame, int frameIndex, LveIndirectBuffer& indirectBuffer) {
+    VkImageView hiZView = hiZ.view != VK_NULL_HANDLE ? hiZ.view : placeholderView;
+    if (set.descriptorSet != VK_NULL_HANDLE &&
+        set.boundDraws == frame.drawBuffer->getBuffer() &&
+        set.boundCommands == indirectBuffer.getBuffer() &&
+        set.boundVisibility == visibilityBuffer->getBuffer() &&
+        set.boundHiZ == hiZView) {
+        return;
+    }
+
+    auto uniformInfo = frame.uniformBuffer->descriptorInfo();
+    auto drawInfo = frame.drawBuffer->descriptorInfo();
+    // the frame's region, so the shader indexes commands from zero
+    VkDescriptorBufferInfo commandInfo{indirectBuffer.getBuffer(), indirectBuffer.getFrameOffset(frameIndex), indirectBuffer.getFrameSize()};
+    VkDescriptorImageInfo hiZInfo{};
+    hiZInfo.sampler = hiZSampler;
+    hiZInfo.imageView = hiZView;
+    hiZInfo.imageLayout = hiZ.view != VK_NULL_HANDLE ? hiZ.layout : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    auto visibilityInfo = visibilityBuffer->descriptorInfo();
+
+    LveDescriptorWriter writer{*cullSetLayout, *descriptorPool};
+    writer.writeBuffer(0, &uniformInfo)
+        .writeBuffer(1, &drawInfo)
+        .writeBuffer(2, &commandInfo)
+        .writeImage(3, &hiZInfo)
+        .writeBuffer(4, &visibilityInfo);
+    // the set is only used by this frame slot, whose previous submission has completed
+    if (set.descriptorSet == VK_NULL_HANDLE) {
+        if (!writer.build(set.descriptorSet)) {
+            throw std::runtime_error("failed to allocate cull descriptor set");
+        }
+    } else {
+        writer.overwrite(set.descriptorSet);
+    }
+    set.boundDraws = frame.drawBuffer->getBuffer();
+    set.boundCommands = indirectBuffer.getBuffer();
+    set.boundVisibility = visibilityBuffer->getBuffer();
+    set.boundHiZ = hiZView;
+}
+
+void GpuCullSystem::cull(
+    FrameInfo& frameInfo,
+    uint32_t firstObject,
+    uint32_t objectCount,
+    CullPass pass,
+    uint32_t commandOffset,
+    uint32_t instanceOffset) {
+    LVE_PROFILE_FUNCTION();
+    assert(frameInfo.indirectBuffer != nullptr && "Culling writes into the frame's indirect buffer");
+    assert(frameInfo.frameIndex == currentFrame && "Call beginFrame with this frame first");
+    assert((pass != CullPass::Late || hasHiZ()) && "The late pass tests against this frame's depth pyramid");
+    auto &frame = frames[frameInfo.frameIndex];
+    VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+    // the late pass reuses what the early pass uploaded
+    if (pass != CullPass::Late) {
+        prepareVisibility(commandBuffer);
+        CullUbo ubo{};
+        LveFrustum frustum = LveFrustum::fromViewProjection(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        std::copy(std::begin(frustum.planes), std::end(frustum.planes), ubo.frustumPlanes);
+        ubo.firstObject = firstObject;
+        ubo.objectCount = objectCount;
+        frame.uniformBuffer->writeToBuffer(&ubo);
+        frame.uniformBuffer->flush();
+        if (drawCount > 0) frame.drawBuffer->flush(drawCount * sizeof(CullDraw), 0);
+    }
+
+    CullPushConstants push{};
+    push.flags = CULL_FRUSTUM;
+    // the early pass draws from last frame's visibility, there is no pyramid of this frame yet
+    if (hasHiZ() && pass != CullPass::Early) {
+        push.flags |= CULL_HIZ;
+        push.hizViewProjection = hiZ.viewProjection;
+        push.hizSize = glm::vec2{static_cast<float>(hiZ.extent.width), static_cast<float>(hiZ.extent.height)};
+        push.hizMipCount = hiZ.mipCount;
+    }
+    if (pass == CullPass::Early) push.flags |= CULL_EARLY;
+    if (pass == CullPass::Late) push.flags |= CULL_LATE;
+    push.commandOffset = commandOffset;
+    push.instanceOffset = instanceOffset;
+
+    CullSet &set = frame.sets[pass == CullPass::Late ? 1 : 0];
+    updateDescriptorSet(set, frame, frameInfo.frameIndex, *frameInfo.indirectBuffer);
+
+    {
+        LveGpuZone gpuZone{frameInfo.gpuProfiler, commandBuffer, pass == CullPass::Late ? "gpu cull late" : "gpu cull"};
+        computePipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set.descriptorSet, 0, nullptr
+        );
+        frameInfo.objectBuffer.bind(commandBuffer, pipelineLayout, 1, VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+        if (objectCount > 0) {
+            vkCmdDispatch(commandBuffer, (objectCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+        }
+    }
+
+    // the indirect draws of this frame read the instance counts, their vertex shaders the
+    // instance table written above
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+}
+
+} // namespace lve
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_compute_pipeline.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_frustum_culler.hpp"
+
+#include <memory>
+#include <vector>
+
+
+namespace lve {
+
+    // mirrors DrawTemplate in cull.comp (std430), the instanced draw shared by the objects of a batch
+    struct CullDraw {
+        // the batch's command in the frame's indirect region, written with instanceCount 0
+        uint32_t command = 0;
+        // the batch's range in the instance table (LveObjectBuffer), one entry per object
+        uint32_t firstInstance = 0;
+        uint32_t padding[2]{};
+    };
+    static_assert(sizeof(CullDraw) == 16, "CullDraw must keep the std430 array stride");
+
+    // a depth pyramid (see LveDepthPyramid), every texel holding the farthest depth below it
+    struct HiZInput {
+        VkImageView view = VK_NULL_HANDLE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        VkExtent2D extent{1, 1};
+        uint32_t mipCount = 1;
+        // projection * view of the camera the depth was rendered with
+        glm::mat4 viewProjection{1.f};
+    };
+
+    // which draws a cull dispatch writes
+    enum class CullPass {
+        // every visible object, tested against the Hi-Z input if one is set
+        Single,
+        // objects visible last frame that pass the frustum test, drawn before the depth pyramid is built
+        Early,
+        // everything against the pyramid of the early draws, writes the objects the early pass missed
+        // into the second command layout and remembers what is visible for the next frame
+        Late
+    };
+
+    /*
+     * Frustum and occlusion culling in a compute pass, one invocation per object.
+     *
+     * Objects come from LveObjectBuffer (model matrix, local bounding sphere and drawIndex into a
+     * per-frame table of CullDraw). Every batch keeps a single instanced indirect command, written
+     * on the cpu with instanceCount 0. A visible object raises its batch's instanceCount with an
+     * atomic and writes its object index into the slot it got in the batch's instance range, so
+     * the survivors are compacted to the front of the range. The draws read the object index from
+     * the instance table (LveObjectBuffer) with firstInstance set to the start of the range.
+     *
+     * The occlusion test samples a Hi-Z pyramid set with setHiZ, projected with the camera the
+     * pyramid was rendered with. Until one is set only the frustum test runs.
+     * cull() records into frameInfo.commandBuffer and must be called outside a render pass.
+     *
+     * Two phase occlusion culling (CullPass::Early then CullPass::Late) keeps a visibility bit per
+     * object across frames, indexed by ObjectData::visibilityIndex. The early pass draws last
+     * frame's visible objects, which become the occluders of this frame's pyramid (LveDepthPyramid),
+     * then the late pass draws whatever became visible. Nothing pops in when the camera turns,
+     * since no object is ever rejected by a pyramid older than the frame.
+     */
+    class GpuCullSystem {
+        public:
+        static constexpr uint32_t GROUP_SIZE = 64;
+        GpuCullSystem(LveDevice& device, VkDescriptorSetLayout objectSetLayout, uint32_t frameCount);
+        ~GpuCullSystem();
+        GpuCullSystem(const GpuCullSystem&) = delete;
+        GpuCullSystem& operator=(const GpuCullSystem&) = delete;
+
+        // reallocates the per frame resources, only while no frame is in flight
+        void setFrameCount(uint32_t count);
+        // rewinds the frame's draw table, grows it first if drawCount does not fit. visibilityCount
+        // bounds ObjectData::visibilityIndex for the two phase passes
+        void beginFrame(int frameIndex, uint32_t drawCount, uint32_t visibilityCount = 0);
+        // returns the drawIndex for ObjectData
+        uint32_t addDraw(const CullDraw& draw);
+        // marks the object at visibilityIndex hidden before this frame's early pass, for a slot
+        // that now belongs to another object
+        void resetVisibility(uint32_t visibilityIndex);
+        void setHiZ(const HiZInput& input);
+        void clearHiZ();
+        bool hasHiZ() const { return hiZ.view != VK_NULL_HANDLE; }
+        // culls objects [firstObject, firstObject + objectCount) into frameInfo.indirectBuffer and
+        // the object buffer's instance table, the draws may read them right after. The late pass
+        // fills the commands and instance ranges commandOffset and instanceOffset behind the ones
+        // of the early pass, and reuses the objects the early pass was given
+        void cull(
+            FrameInfo& frameInfo,
+            uint32_t firstObject,
+            uint32_t objectCount,
+            CullPass pass = CullPass::Single,
+            uint32_t commandOffset = 0,
+            uint32_t instanceOffset = 0);
+
+        VkSampler getHiZSampler() const { return hiZSampler; }
+
+    private:
+        static constexpr uint32_t CULL_FRUSTUM = 1;
+        static constexpr uint32_t CULL_HIZ = 2;
+        static constexpr uint32_t CULL_EARLY = 8;
+        static constexpr uint32_t CULL_LATE = 16;
+
+        // mirrors CullUbo in cull.comp (std140)
+        struct CullUbo {
+            glm::vec4 frustumPlanes[LveFrustum::PLANE_COUNT];
+            uint32_t firstObject = 0;
+            uint32_t objectCount = 0;
+            uint32_t padding[2]{};
+        };
+
+        // mirrors Push in cull.comp
+        struct CullPushConstants {
+            glm::mat4 hizViewProjection{1.f};
+            glm::vec2 hizSize{1.f};
+            uint32_t hizMipCount = 1;
+            uint32_t flags = 0;
+            uint32_t commandOffset = 0;
+            uint32_t instanceOffset = 0;
+        };
+
+        struct CullSet {
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            // what descriptorSet points at, rewritten when any of them changes
+            VkBuffer boundDraws = VK_NULL_HANDLE;
+            VkBuffer boundCommands = VK_NULL_HANDLE;
+            VkBuffer boundVisibility = VK_NULL_HANDLE;
+            VkImageView boundHiZ = VK_NULL_HANDLE;
+        };
+
+        struct Frame {
+            std::unique_ptr<LveBuffer> uniformBuffer;
+            std::unique_ptr<LveBuffer> drawBuffer;
+            uint32_t drawCapacity = 0;
+            // the late pass gets a set of its own, a set bound earlier in the frame cannot be
+            // rewritten when the pyramid it samples is recreated in between
+            CullSet sets[2];
+        };
+
+        void createPipelineLayout(VkDescriptorSetLayout objectSetLayout);
+        void createHiZPlaceholder();
+        void createFrames(uint32_t frameCount);
+        void createDrawBuffer(Frame& frame, uint32_t capacity);
+        // grows the visibility buffer to visibilityCount and clears it on the gpu, every object
+        // counts as hidden for a frame after that. Otherwise clears the entries of visibilityResets
+        void prepareVisibility(VkCommandBuffer commandBuffer);
+        void updateDescriptorSet(CullSet& set, Frame& frame, int frameIndex, LveIndirectBuffer& indirectBuffer);
+
+        LveDevice &lveDevice;
+
+        std::unique_ptr<LveDescriptorSetLayout> cullSetLayout;
+        std::unique_ptr<LveDescriptorPool> descriptorPool;
+        VkPipelineLayout pipelineLayout;
+        std::unique_ptr<LveComputePipeline> computePipeline;
+
+        std::vector<Frame> frames;
+        int currentFrame = 0;
+        uint32_t drawCount = 0;
+
+        // a visibility flag per object, shared by all frames in flight
+        std::unique_ptr<LveBuffer> visibilityBuffer;
+        uint32_t visibilityCapacity = 0;
+        uint32_t visibilityCount = 1;
+        // cleared by the next prepareVisibility
+        std::vector<uint32_t> visibilityResets;
+
+        HiZInput hiZ{};
+        VkSampler hiZSampler = VK_NULL_HANDLE;
+        // 1x1 at the far plane, keeps the sampler binding valid while occlusion culling is off
+        VkImage placeholderImage = VK_NULL_HANDLE;
+        LveAllocation placeholderMemory{};
+        VkImageView placeholderView = VK_NULL_HANDLE;
+    };
+}
@@ -6,7 +6,7 @@
 
 
 namespace lve {
-void KeyboardMovementController::moveInPlanceXZ(GLFWwindow *window, float dt, LveGameObject &gameObject) {
+void KeyboardMovementController::moveInPlanceXZ(GLFWwindow *window, float dt, LveWorld &world) {
 
     glfwGetCursorPos(window, &currentX, &currentY);
 
@@ -43,43 +43,50 @@ void KeyboardMovementController::moveInPlanceXZ(GLFWwindow *window, float dt, Lv
         rotate.x -= 1.f;
     }
 
-    if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-
-        gameObject.transform.rotation += lookSpeed * dt * rotate;
-    }
-
-    gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-    gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
-
-    float yaw = gameObject.transform.rotation.y;
-    const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
-    const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
-    const glm::vec3 upDir{0.f, -1.f, 0.f};
-    glm::vec3 moveDir{0.f};
+    // in the entity's yaw frame: x right, y up, z forward
+    glm::vec3 move{0.f};
 
     if (glfwGetKey(window, keys.moveForward) == GLFW_PRESS) {
-        moveDir += forwardDir;
+        move.z += 1.f;
     }
     if (glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) {
-        moveDir -= forwardDir;
+        move.z -= 1.f;
     }
     if (glfwGetKey(window, keys.moveRight) == GLFW_PRESS) {
-        moveDir += rightDir;
+        move.x += 1.f;
     }
     if (glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) {
-        moveDir -= rightDir;
+        move.x -= 1.f;
     }
     if (glfwGetKey(window, keys.moveUp) == GLFW_PRESS) {
-        moveDir += upDir;
+        move.y += 1.f;
     }
     if (glfwGetKey(window, keys.moveDown) == GLFW_PRESS) {
-        moveDir -= upDir;
+        move.y -= 1.f;
     }
 
-    if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
+    world.each<TransformComponent, KeyboardControlComponent>([&](LveEntity, TransformComponent &transform, KeyboardControlComponent &) {
+        glm::vec3 rotation = transform.getRotation();
+        if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
 
-        gameObject.transform.translation += lookSpeed * dt * glm::normalize(moveDir);
-    }
+            rotation += lookSpeed * dt * rotate;
+        }
+
+        rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+        rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+        transform.setRotation(rotation);
+
+        float yaw = rotation.y;
+        const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
+        const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
+        const glm::vec3 upDir{0.f, -1.f, 0.f};
+        const glm::vec3 moveDir = move.x * rightDir + move.y * upDir + move.z * forwardDir;
+
+        if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
+
+            transform.setTranslation(transform.getTranslation() + lookSpeed * dt * glm::normalize(moveDir));
+        }
+    });
 
 }
 } // namespace lve
\ No newline at end of file
@@ -5,6 +5,9 @@
 
 namespace lve {
 
+// tags the entities KeyboardMovementController moves, usually just the viewer
+struct KeyboardControlComponent {};
+
 class KeyboardMovementController {
     public:
 
@@ -21,7 +24,8 @@ class KeyboardMovementController {
         int lookDown = GLFW_KEY_DOWN;
     };
 
-    void moveInPlanceXZ(GLFWwindow* window, float dt, LveGameObject& gameObject);
+    // reads the input once and moves every entity with a TransformComponent and a KeyboardControlComponent
+    void moveInPlanceXZ(GLFWwindow* window, float dt, LveWorld& world);
 
     KeyMappings keys{};
     float moveSpeed {3.f};
@@ -0,0 +1,465 @@
+#include "lve_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+uint32_t bitScanForward(uint64_t mask) { return static_cast<uint32_t>(__builtin_ctzll(mask)); }
+uint32_t bitScanReverse(uint64_t mask) { return 63 - static_cast<uint32_t>(__builtin_clzll(mask)); }
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+/*
+ * One vkAllocateMemory worth of device memory.
+ *
+ * Pooled blocks are carved up with TLSF: free ranges are kept in lists bucketed by a first level
+ * (power of two) and a second level (32 linear subdivisions), with a bitmap per level so the
+ * smallest fitting bucket is found with two bit scans. Ranges are also linked to their physical
+ * neighbours so a freed range merges with adjacent free ones immediately.
+ */
+class LveMemoryBlock {
+ public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  LveMemoryBlock(
+      VkDevice device,
+      VkDeviceMemory memory,
+      VkDeviceSize size,
+      void *mapped,
+      uint32_t poolIndex,
+      bool dedicated)
+      : device{device},
+        memory{memory},
+        size{size},
+        mapped{mapped},
+        poolIndex{poolIndex},
+        dedicated{dedicated} {
+    flBitmap = 0;
+    slBitmap.fill(0);
+    freeHeads.fill(NONE);
+    if (!dedicated) {
+      uint32_t root = newNode();
+      nodes[root].offset = 0;
+      nodes[root].size = size;
+      insertFree(root);
+    }
+  }
+
+  ~LveMemoryBlock() {
+    if (mapped) {
+      vkUnmapMemory(device, memory);
+    }
+    vkFreeMemory(device, memory, nullptr);
+  }
+
+  LveMemoryBlock(const LveMemoryBlock &) = delete;
+  LveMemoryBlock &operator=(const LveMemoryBlock &) = delete;
+
+  bool allocate(
+      VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize &offset, uint32_t &node) {
+    // most free ranges start aligned already, only pay for worst case padding when they don't
+    uint32_t candidate = findFree(allocSize);
+    if (candidate == NONE ||
+        alignUp(nodes[candidate].offset, alignment) + allocSize >
+            nodes[candidate].offset + nodes[candidate].size) {
+      candidate = findFree(allocSize + alignment - 1);
+    }
+    if (candidate == NONE) {
+      return false;
+    }
+
+    removeFree(candidate);
+    VkDeviceSize alignedOffset = alignUp(nodes[candidate].offset, alignment);
+    VkDeviceSize padding = alignedOffset - nodes[candidate].offset;
+    if (padding > 0) {
+      uint32_t front = newNode();
+      nodes[front].offset = nodes[candidate].offset;
+      nodes[front].size = padding;
+      nodes[front].prevPhys = nodes[candidate].prevPhys;
+      nodes[front].nextPhys = candidate;
+      if (nodes[front].prevPhys != NONE) {
+        nodes[nodes[front].prevPhys].nextPhys = front;
+      }
+      nodes[candidate].prevPhys = front;
+      nodes[candidate].offset = alignedOffset;
+      nodes[candidate].size -= padding;
+      insertFree(front);
+    }
+    if (nodes[candidate].size > allocSize) {
+      uint32_t back = newNode();
+      nodes[back].offset = nodes[candidate].offset + allocSize;
+      nodes[back].size = nodes[candidate].size - allocSize;
+      nodes[back].prevPhys = candidate;
+      nodes[back].nextPhys = nodes[candidate].nextPhys;
+      if (nodes[back].nextPhys != NONE) {
+        nodes[nodes[back].nextPhys].prevPhys = back;
+      }
+      nodes[candidate].nextPhys = back;
+      nodes[candidate].size = allocSize;
+      insertFree(back);
+    }
+
+    nodes[candidate].free = false;
+    usedBytes += allocSize;
+    offset = alignedOffset;
+    node = candidate;
+    return true;
+  }
+
+  void free(uint32_t node) {
+    assert(!nodes[node].free && "Freeing a range twice");
+    usedBytes -= nodes[node].size;
+    nodes[node].free = true;
+
+    uint32_t next = nodes[node].nextPhys;
+    if (next != NONE && nodes[next].free) {
+      removeFree(next);
+      nodes[node].size += nodes[next].size;
+      nodes[node].nextPhys = nodes[next].nextPhys;
+      if (nodes[node].nextPhys != NONE) {
+        nodes[nodes[node].nextPhys].prevPhys = node;
+      }
+      releaseNode(next);
+    }
+    uint32_t prev = nodes[node].prevPhys;
+    if (prev != NONE && nodes[prev].free) {
+      removeFree(prev);
+      nodes[prev].size += nodes[node].size;
+      nodes[prev].nextPhys = nodes[node].nextPhys;
+      if (nodes[prev].nextPhys != NONE) {
+        nodes[nodes[prev].nextPhys].prevPhys = prev;
+      }
+      releaseNode(node);
+      node = prev;
+    }
+    insertFree(node);
+  }
+
+  bool isEmpty() const { return usedBytes == 0; }
+  VkDeviceSize getSize() const { return size; }
+  VkDeviceMemory getMemory() const { return memory; }
+  void *getMapped() const { return mapped; }
+  uint32_t getPoolIndex() const { return poolIndex; }
+  bool isDedicated() const { return dedicated; }
+
+ private:
+  static constexpr uint32_t SL_LOG2 = 5;
+  static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+  // sizes below this share first level 0 and are split linearly
+  static constexpr uint32_t SMALL_LOG2 = 8;
+  static constexpr uint32_t FL_COUNT = 64 - SMALL_LOG2 + 1;
+
+  struct Node {
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t prevPhys = NONE;
+    uint32_t nextPhys = NONE;
+    uint32_t prevFree = NONE;
+    uint32_t nextFree = NONE;
+    bool free = false;
+  };
+
+  static void mapping(VkDeviceSize rangeSize, uint32_t &fl, uint32_t &sl) {
+    if (rangeSize < (VkDeviceSize{1} << SMALL_LOG2)) {
+      fl = 0;
+      sl = static_cast<uint32_t>(rangeSize >> (SMALL_LOG2 - SL_LOG2));
+    } else {
+      uint32_t msb = bitScanReverse(rangeSize);
+      fl = msb - SMALL_LOG2 + 1;
+      sl = static_cast<uint32_t>(rangeSize >> (msb - SL_LOG2)) - SL_COUNT;
+    }
+  }
+
+  // returns a free range of at least rangeSize bytes, or NONE
+  uint32_t findFree(VkDeviceSize rangeSize) const {
+    // round up to the next bucket so every range in the bucket we land on is large enough
+    VkDeviceSize granule = rangeSize < (VkDeviceSize{1} << SMALL_LOG2)
+                               ? VkDeviceSize{1} << (SMALL_LOG2 - SL_LOG2)
+                               : VkDeviceSize{1} << (bitScanReverse(rangeSize) - SL_LOG2);
+    uint32_t fl, sl;
+    mapping(rangeSize + granule - 1, fl, sl);
+    if (fl >= FL_COUNT) {
+      return NONE;
+    }
+
+    uint32_t slMap = slBitmap[fl] & (~0u << sl);
+    if (slMap == 0) {
+      uint64_t flMap = flBitmap & (~uint64_t{0} << (fl + 1));
+      if (flMap == 0) {
+        return NONE;
+      }
+      fl = bitScanForward(flMap);
+      slMap = slBitmap[fl];
+    }
+    sl = bitScanForward(slMap);
+    return freeHeads[fl * SL_COUNT + sl];
+  }
+
+  void insertFree(uint32_t node) {
+    uint32_t fl, sl;
+    mapping(nodes[node].size, fl, sl);
+    uint32_t &head = freeHeads[fl * SL_COUNT + sl];
+    nodes[node].free = true;
+    nodes[node].prevFree = NONE;
+    nodes[node].nextFree = head;
+    if (head != NONE) {
+      nodes[head].prevFree = node;
+    }
+    head = node;
+    flBitmap |= uint64_t{1} << fl;
+    slBitmap[fl] |= 1u << sl;
+  }
+
+  void removeFree(uint32_t node) {
+    uint32_t fl, sl;
+    mapping(nodes[node].size, fl, sl);
+    Node &n = nodes[node];
+    if (n.prevFree != NONE) {
+      nodes[n.prevFree].nextFree = n.nextFree;
+    } else {
+      freeHeads[fl * SL_COUNT + sl] = n.nextFree;
+    }
+    if (n.nextFree != NONE) {
+      nodes[n.nextFree].prevFree = n.prevFree;
+    }
+    if (freeHeads[fl * SL_COUNT + sl] == NONE) {
+      slBitmap[fl] &= ~(1u << sl);
+      if (slBitmap[fl] == 0) {
+        flBitmap &= ~(uint64_t{1} << fl);
+      }
+    }
+    n.prevFree = n.nextFree = NONE;
+  }
+
+  uint32_t newNode() {
+    if (!unusedNodes.empty()) {
+      uint32_t node = unusedNodes.back();
+      unusedNodes.pop_back();
+      nodes[node] = Node{};
+      return node;
+    }
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+  }
+
+  void releaseNode(uint32_t node) { unusedNodes.push_back(node); }
+
+  VkDevice device;
+  VkDeviceMemory memory;
+  VkDeviceSize size;
+  void *mapped;
+  uint32_t poolIndex;
+  bool dedicated;
+  VkDeviceSize usedBytes = 0;
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> unusedNodes;
+  uint64_t flBitmap;
+  std::array<uint32_t, FL_COUNT> slBitmap;
+  std::array<uint32_t, FL_COUNT * SL_COUNT> freeHeads;
+};
+
+LveAllocator::LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : device{device} {
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  bufferImageGranularity = properties.limits.bufferImageGranularity;
+  nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+  pools.resize(memoryProperties.memoryTypeCount * 2);
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    // small heaps (e.g. the 256MB BAR window) get proportionally smaller blocks
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+    VkDeviceSize blockSize = std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+    for (uint32_t kind = 0; kind < 2; kind++) {
+      pools[i * 2 + kind].memoryTypeIndex = i;
+      pools[i * 2 + kind].blockSize = blockSize;
+    }
+  }
+}
+
+LveAllocator::~LveAllocator() {
+  assert(allocationCount == 0 && "Device memory still allocated when destroying the allocator");
+}
+
+uint32_t LveAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+
+  throw std::runtime_error("failed to find suitable memory type!");
+}
+
+LveAllocator::Pool &LveAllocator::getPool(uint32_t memoryTypeIndex, ResourceKind kind) {
+  // without a granularity restriction buffers and images can share blocks
+  uint32_t kindIndex = (bufferImageGranularity > 1 && kind == ResourceKind::Optimal) ? 1 : 0;
+  return pools[memoryTypeIndex * 2 + kindIndex];
+}
+
+std::unique_ptr<LveMemoryBlock> LveAllocator::createBlock(
+    uint32_t poolIndex, VkDeviceSize size, bool dedicated) {
+  uint32_t memoryTypeIndex = poolIndex / 2;
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+  VkDeviceMemory memory;
+  if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate device memory block!");
+  }
+
+  void *mapped = nullptr;
+  if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+      vkFreeMemory(device, memory, nullptr);
+      throw std::runtime_error("failed to map device memory block!");
+    }
+  }
+
+  return std::make_unique<LveMemoryBlock>(device, memory, size, mapped, poolIndex, dedicated);
+}
+
+LveAllocation LveAllocator::allocate(
+    const VkMemoryRequirements &requirements,
+    VkMemoryPropertyFlags properties,
+    ResourceKind kind) {
+  uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+  VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+  std::lock_guard<std::mutex> lock{mutex};
+  Pool &pool = getPool(memoryTypeIndex, kind);
+  uint32_t poolIndex = static_cast<uint32_t>(&pool - pools.data());
+
+  LveAllocation allocation{};
+  allocation.size = requirements.size;
+  allocation.memoryTypeIndex = memoryTypeIndex;
+
+  if (requirements.size > pool.blockSize / 2) {
+    dedicatedBlocks.push_back(createBlock(poolIndex, requirements.size, true));
+    allocation.block = dedicatedBlocks.back().get();
+    allocation.offset = 0;
+  } else {
+    for (auto &block : pool.blocks) {
+      if (block->allocate(requirements.size, alignment, allocation.offset, allocation.node)) {
+        allocation.block = block.get();
+        break;
+      }
+    }
+    if (allocation.block == nullptr) {
+      pool.blocks.push_back(createBlock(poolIndex, pool.blockSize, false));
+      allocation.block = pool.blocks.back().get();
+      if (!allocation.block->allocate(
+              requirements.size, alignment, allocation.offset, allocation.node)) {
+        throw std::runtime_error("failed to sub-allocate device memory!");
+      }
+    }
+  }
+
+  allocation.memory = allocation.block->getMemory();
+  if (allocation.block->getMapped()) {
+    allocation.mapped = static_cast<char *>(allocation.block->getMapped()) + allocation.offset;
+  }
+  allocationCount++;
+  usedBytes += allocation.size;
+  return allocation;
+}
+
+void LveAllocator::free(LveAllocation &allocation) {
+  if (!allocation.isValid()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+  LveMemoryBlock *block = allocation.block;
+  if (block->isDedicated()) {
+    auto it = std::find_if(
+        dedicatedBlocks.begin(),
+        dedicatedBlocks.end(),
+        [block](const std::unique_ptr<LveMemoryBlock> &b) { return b.get() == block; });
+    assert(it != dedicatedBlocks.end() && "Unknown dedicated allocation");
+    dedicatedBlocks.erase(it);
+  } else {
+    block->free(allocation.node);
+    if (block->isEmpty()) {
+      // keep a single empty block around so a pool does not thrash around a block boundary
+      auto &blocks = pools[block->getPoolIndex()].blocks;
+      auto emptyBlocks = std::count_if(
+          blocks.begin(), blocks.end(), [](const std::unique_ptr<LveMemoryBlock> &b) {
+            return b->isEmpty();
+          });
+      if (emptyBlocks > 1) {
+        blocks.erase(std::find_if(
+            blocks.begin(), blocks.end(), [block](const std::unique_ptr<LveMemoryBlock> &b) {
+              return b.get() == block;
+            }));
+      }
+    }
+  }
+
+  allocationCount--;
+  usedBytes -= allocation.size;
+  allocation = LveAllocation{};
+}
+
+VkMappedMemoryRange LveAllocator::mappedRange(
+    const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const {
+  VkDeviceSize start = allocation.offset + offset;
+  VkDeviceSize end =
+      size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : start + size;
+  start = start & ~(nonCoherentAtomSize - 1);
+  end = std::min(alignUp(end, nonCoherentAtomSize), allocation.block->getSize());
+
+  VkMappedMemoryRange range{};
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = allocation.memory;
+  range.offset = start;
+  range.size = end - start;
+  return range;
+}
+
+VkResult LveAllocator::flush(
+    const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+  VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+  return vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+VkResult LveAllocator::invalidate(
+    const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+  VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+  return vkInvalidateMappedMemoryRanges(device, 1, &range);
+}
+
+LveAllocator::Stats LveAllocator::getStats() {
+  std::lock_guard<std::mutex> lock{mutex};
+  Stats stats{};
+  for (auto &pool : pools) {
+    for (auto &block : pool.blocks) {
+      stats.blockCount++;
+      stats.reservedBytes += block->getSize();
+    }
+  }
+  for (auto &block : dedicatedBlocks) {
+    stats.dedicatedCount++;
+    stats.reservedBytes += block->getSize();
+  }
+  stats.allocationCount = allocationCount;
+  stats.usedBytes = usedBytes;
+  return stats;
+}
+
+}  // namespace lve
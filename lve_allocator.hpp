@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+class LveMemoryBlock;
+
+/*
+ * A range of device memory handed out by LveAllocator.
+ *
+ * memory/offset are what gets passed to vkBind*Memory. mapped is only set for host visible memory
+ * types, whose blocks stay mapped for their whole lifetime.
+ */
+struct LveAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  void *mapped = nullptr;
+  uint32_t memoryTypeIndex = 0;
+
+  // allocator bookkeeping
+  LveMemoryBlock *block = nullptr;
+  uint32_t node = 0;
+
+  bool isValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+/*
+ * Sub-allocates device memory out of large blocks instead of calling vkAllocateMemory per
+ * resource.
+ *
+ * Every memory type gets its own pools of blocks, managed with a TLSF (two level segregated fit)
+ * allocator so allocating and freeing are O(1). When bufferImageGranularity is larger than 1,
+ * linear resources (buffers) and optimal-tiling images live in separate pools so they can never
+ * share a granularity page. Requests larger than half a block get a dedicated allocation.
+ */
+class LveAllocator {
+ public:
+  enum class ResourceKind { Linear, Optimal };
+
+  struct Stats {
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize reservedBytes = 0;
+    VkDeviceSize usedBytes = 0;
+  };
+
+  static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+  LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+  ~LveAllocator();
+
+  LveAllocator(const LveAllocator &) = delete;
+  LveAllocator &operator=(const LveAllocator &) = delete;
+
+  LveAllocation allocate(
+      const VkMemoryRequirements &requirements,
+      VkMemoryPropertyFlags properties,
+      ResourceKind kind);
+  void free(LveAllocation &allocation);
+
+  // ranges are relative to the allocation and get widened to nonCoherentAtomSize
+  VkResult flush(
+      const LveAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+  VkResult invalidate(
+      const LveAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+  uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+  Stats getStats();
+
+ private:
+  struct Pool {
+    uint32_t memoryTypeIndex;
+    VkDeviceSize blockSize;
+    std::vector<std::unique_ptr<LveMemoryBlock>> blocks;
+  };
+
+  Pool &getPool(uint32_t memoryTypeIndex, ResourceKind kind);
+  std::unique_ptr<LveMemoryBlock> createBlock(
+      uint32_t poolIndex, VkDeviceSize size, bool dedicated);
+  VkMappedMemoryRange mappedRange(
+      const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  VkDeviceSize bufferImageGranularity;
+  VkDeviceSize nonCoherentAtomSize;
+
+  std::mutex mutex;
+  // indexed by memoryTypeIndex * 2 + kind
+  std::vector<Pool> pools;
+  std::vector<std::unique_ptr<LveMemoryBlock>> dedicatedBlocks;
+  uint32_t allocationCount = 0;
+  VkDeviceSize usedBytes = 0;
+};
+
+}  // namespace lve
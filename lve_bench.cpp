@@ -0,0 +1,430 @@
+// Deterministic benchmark: renders a named scene along a camera path for a fixed number of frames
+// with a fixed timestep and writes per frame cpu and gpu timings as json.
+//
+//   lve_bench --scene vases --frames 1000 --out vases.json
+//   lve_bench --scene terrain --path camera_path.txt --headless --screenshot terrain.png
+
+#include "lve_bench_scenes.hpp"
+#include "lve_camera.hpp"
+#include "lve_camera_path.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_stats.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_indirect_buffer.hpp"
+#include "gpu_cull_system.hpp"
+#include "lve_depth_pyramid.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_object_buffer.hpp"
+#include "lve_profiler.hpp"
+#include "lve_renderer.hpp"
+#include "lve_secondary_recorder.hpp"
+#include "lve_upload_batch.hpp"
+#include "lve_window.hpp"
+#include "lve_worker_pool.hpp"
+#include "point_light_system.hpp"
+#include "simple_render_system.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct BenchOptions {
+        std::string scene = "vases";
+        std::string pathFile;
+        std::string outFile = "lve_bench.json";
+        std::string screenshotFile;
+        uint32_t frames = 1000;
+        // rendered before measuring, fills caches and lets the driver settle its clocks
+        uint32_t warmupFrames = 60;
+        float dt = 1.f / 60.f;
+        bool headless = false;
+        bool vsync = false;
+        uint32_t framesInFlight = 2;
+        // threads recording secondary command buffers, 0 records inline in the primary
+        uint32_t recordThreads = 0;
+        // multi draw indirect where supported
+        bool indirect = true;
+        // culling in a compute pass, needs indirect
+        bool gpuCull = true;
+        // two phase occlusion culling against a depth pyramid, needs gpuCull
+        bool occlusion = true;
+        uint32_t width = 1280;
+        uint32_t height = 720;
+    };
+
+    struct FrameTiming {
+        float cpuFrameMs = 0.f;
+        // begin of recording to submit, what the render systems cost on the cpu
+        float cpuRecordMs = 0.f;
+        float gpuMs = 0.f;
+        // the in-flight fence, waited on before acquire
+        float fenceWaitMs = 0.f;
+        float acquireWaitMs = 0.f;
+        float presentWaitMs = 0.f;
+    };
+
+    void printUsage() {
+        std::cout << "usage: lve_bench [--scene name] [--frames n] [--warmup n] [--dt seconds]\n"
+                     "                 [--path camera_path.txt] [--out results.json]\n"
+                     "                 [--headless] [--width w] [--height h] [--screenshot out.png]\n"
+                     "                 [--frames-in-flight n] [--threads n] [--no-indirect] [--no-gpu-cull]\n"
+                     "                 [--no-occlusion] [--vsync]\n"
+                     "scenes:";
+        for (auto &name : lve::benchSceneNames()) std::cout << " " << name;
+        std::cout << std::endl;
+    }
+
+    bool parseArgs(int argc, char *argv[], BenchOptions &options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--scene") options.scene = value();
+            else if (arg == "--frames") options.frames = std::stoul(value());
+            else if (arg == "--warmup") options.warmupFrames = std::stoul(value());
+            else if (arg == "--dt") options.dt = std::stof(value());
+            else if (arg == "--path") options.pathFile = value();
+            else if (arg == "--out") options.outFile = value();
+            else if (arg == "--screenshot") options.screenshotFile = value();
+            else if (arg == "--headless") options.headless = true;
+            else if (arg == "--vsync") options.vsync = true;
+            else if (arg == "--frames-in-flight") options.framesInFlight = std::stoul(value());
+            else if (arg == "--threads") options.recordThreads = std::stoul(value());
+            else if (arg == "--no-indirect") options.indirect = false;
+            else if (arg == "--no-gpu-cull") options.gpuCull = false;
+            else if (arg == "--no-occlusion") options.occlusion = false;
+            else if (arg == "--width") options.width = std::stoul(value());
+            else if (arg == "--height") options.height = std::stoul(value());
+            else return false;
+        }
+        return options.frames > 0 && options.dt > 0.f;
+    }
+
+    std::string jsonString(const std::string &text) {
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '\n') {
+                quoted += "\\n";
+                continue;
+            }
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void writeSummary(std::ofstream &out, const char *name, const lve::LveFrameStats::Summary &summary) {
+        out << "    " << jsonString(name) << ": {\"avg\": " << summary.averageMs
+            << ", \"p50\": " << summary.p50Ms << ", \"p95\": " << summary.p95Ms
+            << ", \"p99\": " << summary.p99Ms << ", \"max\": " << summary.maxMs
+            << ", \"onePercentLowFps\": " << summary.onePercentLowFps << "}";
+    }
+
+    bool writeResults(
+        const BenchOptions &options,
+        const std::string &deviceName,
+        const lve::LveRendererSettings &settings,
+        const std::vector<FrameTiming> &timings,
+        const lve::LveGpuProfiler &gpuProfiler,
+        bool indirect,
+        bool gpuCull,
+        bool occlusion) {
+        std::ofstream out{options.outFile};
+        if (!out) return false;
+
+        // percentiles over the whole run, no window and no periodic logging
+        lve::LveFrameStats stats{timings.size(), 0.f};
+        lve::LveFrameStats recordStats{timings.size(), 0.f};
+        for (auto &timing : timings) {
+            stats.record({timing.cpuFrameMs, timing.gpuMs, timing.fenceWaitMs, timing.acquireWaitMs, timing.presentWaitMs});
+            recordStats.record({timing.cpuRecordMs, 0.f, 0.f, 0.f, 0.f});
+        }
+
+        out << "{\n";
+        out << "  \"scene\": " << jsonString(options.scene) << ",\n";
+        out << "  \"path\": " << jsonString(options.pathFile.empty() ? "builtin" : options.pathFile) << ",\n";
+        out << "  \"device\": " << jsonString(deviceName) << ",\n";
+        out << "  \"frames\": " << options.frames << ",\n";
+        out << "  \"warmupFrames\": " << options.warmupFrames << ",\n";
+        out << "  \"dt\": " << options.dt << ",\n";
+        out << "  \"width\": " << options.width << ",\n";
+        out << "  \"height\": " << options.height << ",\n";
+        out << "  \"headless\": " << (options.headless ? "true" : "false") << ",\n";
+        out << "  \"framesInFlight\": " << settings.framesInFlight << ",\n";
+        out << "  \"recordThreads\": " << options.recordThreads << ",\n";
+        out << "  \"indirect\": " << (indirect ? "true" : "false") << ",\n";
+        out << "  \"gpuCull\": " << (gpuCull ? "true" : "false") << ",\n";
+        out << "  \"occlusion\": " << (occlusion ? "true" : "false") << ",\n";
+        out << "  \"presentMode\": " << jsonString(lve::LveRendererSettings::presentModeName(settings.presentMode)) << ",\n";
+        out << "  \"hitches\": " << stats.getHitchCount() << ",\n";
+        out << "  \"summary\": {\n";
+        writeSummary(out, "cpuFrameMs", stats.summarize(lve::LveFrameStats::Metric::CpuFrame));
+        out << ",\n";
+        writeSummary(out, "cpuRecordMs", recordStats.summarize(lve::LveFrameStats::Metric::CpuFrame));
+        out << ",\n";
+        writeSummary(out, "gpuMs", stats.summarize(lve::LveFrameStats::Metric::Gpu));
+        out << ",\n";
+        writeSummary(out, "fenceWaitMs", stats.summarize(lve::LveFrameStats::Metric::FenceWait));
+        out << ",\n";
+        writeSummary(out, "acquireWaitMs", stats.summarize(lve::LveFrameStats::Metric::AcquireWait));
+        out << ",\n";
+        writeSummary(out, "presentWaitMs", stats.summarize(lve::LveFrameStats::Metric::PresentWait));
+        out << "\n  },\n";
+        // per pass gpu zones over the profiler's history, the last HISTORY_SIZE frames
+        out << "  \"gpuZones\": " << jsonString(gpuProfiler.report()) << ",\n";
+        out << "  \"perFrame\": [\n";
+        for (size_t i = 0; i < timings.size(); i++) {
+            auto &timing = timings[i];
+            out << "    {\"cpu\": " << timing.cpuFrameMs << ", \"record\": " << timing.cpuRecordMs
+                << ", \"gpu\": " << timing.gpuMs << ", \"fence\": " << timing.fenceWaitMs
+                << ", \"acquire\": " << timing.acquireWaitMs
+                << ", \"present\": " << timing.presentWaitMs << "}"
+                << (i + 1 < timings.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    void runBench(const BenchOptions &options) {
+        using namespace lve;
+        LVE_PROFILE_THREAD("main");
+
+        LveRendererSettings settings{};
+        settings.framesInFlight = options.framesInFlight;
+        settings.presentMode = options.vsync ? VK_PRESENT_MODE_FIFO_KHR : VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+        std::unique_ptr<LveWindow> lveWindow;
+        std::unique_ptr<LveDevice> lveDevice;
+        std::unique_ptr<LveRenderer> lveRenderer;
+        if (options.headless) {
+            lveDevice = std::make_unique<LveDevice>();
+            lveRenderer = std::make_unique<LveRenderer>(*lveDevice, VkExtent2D{options.width, options.height}, settings);
+        } else {
+            lveWindow = std::make_unique<LveWindow>(options.width, options.height, "lve_bench " + options.scene);
+            lveDevice = std::make_unique<LveDevice>(*lveWindow);
+            lveRenderer = std::make_unique<LveRenderer>(*lveWindow, *lveDevice, settings);
+        }
+        LveDevice &device = *lveDevice;
+        LveRenderer &renderer = *lveRenderer;
+
+        {
+            auto meshPool = std::make_unique<LveMeshPool>(device, sizeof(LveModel::Vertex));
+            LveWorld world;
+            LveCameraPath cameraPath;
+            {
+                LveUploadBatch uploadBatch{device};
+                if (!loadBenchScene(options.scene, device, uploadBatch, *meshPool, world, cameraPath)) {
+                    throw std::runtime_error("unknown scene " + options.scene);
+                }
+                uploadBatch.submitAndWait();
+            }
+            // a recorded path replaces the scene's own
+            if (!options.pathFile.empty()) {
+                cameraPath.clear();
+                if (!cameraPath.loadFromFile(options.pathFile) || cameraPath.empty()) {
+                    throw std::runtime_error("failed to load camera path " + options.pathFile);
+                }
+            }
+            std::cout << "scene " << options.scene << ": " << world.size() << " entities, "
+                      << cameraPath.keyCount() << " path keys over " << cameraPath.getDuration() << " s" << std::endl;
+
+            uint32_t frameCount = renderer.getFramesInFlight();
+            auto globalPool = LveDescriptorPool::Builder(device)
+                .setMaxSets(frameCount)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount)
+                .build();
+            auto globalSetLayout = LveDescriptorSetLayout::Builder(device)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .build();
+            std::vector<std::unique_ptr<LveBuffer>> uboBuffers(frameCount);
+            std::vector<VkDescriptorSet> globalDescriptorSets(frameCount);
+            for (uint32_t i = 0; i < frameCount; i++) {
+                uboBuffers[i] = std::make_unique<LveBuffer>(
+                    device,
+                    sizeof(GlobalUbo),
+                    1,
+                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+                uboBuffers[i]->map();
+                auto bufferInfo = uboBuffers[i]->descriptorInfo();
+                LveDescriptorWriter(*globalSetLayout, *globalPool)
+                    .writeBuffer(0, &bufferInfo)
+                    .build(globalDescriptorSets[i]);
+            }
+
+            LveObjectBuffer objectBuffer{device, frameCount};
+            LveGpuProfiler gpuProfiler{device, frameCount};
+            std::unique_ptr<LveIndirectBuffer> indirectBuffer;
+            if (options.indirect && LveIndirectBuffer::isSupported(device)) {
+                indirectBuffer = std::make_unique<LveIndirectBuffer>(device, frameCount);
+            }
+            std::unique_ptr<GpuCullSystem> gpuCullSystem;
+            if (options.gpuCull && indirectBuffer) {
+                gpuCullSystem = std::make_unique<GpuCullSystem>(device, objectBuffer.getDescriptorSetLayout(), frameCount);
+            }
+            std::unique_ptr<LveDepthPyramid> depthPyramid;
+            if (options.occlusion && gpuCullSystem) {
+                depthPyramid = std::make_unique<LveDepthPyramid>(device, frameCount);
+            }
+            std::unique_ptr<LveWorkerPool> workerPool;
+            std::unique_ptr<LveSecondaryRecorder> secondaryRecorder;
+            if (options.recordThreads > 0) {
+                workerPool = std::make_unique<LveWorkerPool>(options.recordThreads);
+                secondaryRecorder = std::make_unique<LveSecondaryRecorder>(device, *workerPool, frameCount);
+            }
+            if (!gpuProfiler.isSupported()) {
+                std::cerr << "timestamp queries are not supported, gpu times will be 0" << std::endl;
+            }
+            SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), objectBuffer.getDescriptorSetLayout()};
+            PointLightSytem pointLightSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+            LveCamera camera{};
+
+            // the gpu time of a frame is read back when its slot comes around again, so the run
+            // goes on for frameCount more frames and every slot remembers which frame it rendered
+            const uint32_t measuredEnd = options.warmupFrames + options.frames;
+            const uint32_t totalFrames = measuredEnd + frameCount;
+            std::vector<FrameTiming> timings(options.frames);
+            std::vector<int64_t> slotFrame(frameCount, -1);
+
+            auto loopTime = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0; frame < totalFrames;) {
+                if (lveWindow) {
+                    glfwPollEvents();
+                    if (lveWindow->shouldClose()) throw std::runtime_error("window closed before the run finished");
+                }
+                // simulated time only depends on the frame number, never on the wall clock
+                float time = frame * options.dt;
+                glm::vec3 viewPosition{};
+                glm::vec3 viewRotation{};
+                cameraPath.sample(time, viewPosition, viewRotation);
+                camera.setViewYXZ(viewPosition, viewRotation);
+                camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), 0.1f, 100.f);
+
+                renderer.waitForFrameFence();
+                auto commandBuffer = renderer.beginFrame();
+                // the swap chain was recreated, render the same frame again so no sample is left empty
+                if (!commandBuffer) continue;
+                auto recordStart = std::chrono::steady_clock::now();
+
+                int frameIndex = renderer.getFrameIndex();
+                FrameInfo frameInfo{
+                    frameIndex,
+                    options.dt,
+                    commandBuffer,
+                    camera,
+                    globalDescriptorSets[frameIndex],
+                    world,
+                    objectBuffer,
+                    gpuProfiler,
+                    secondaryRecorder.get(),
+                    indirectBuffer.get()
+                };
+                gpuProfiler.beginFrame(commandBuffer, frameIndex);
+                // beginFrame read back what this slot rendered last time
+                int64_t previousFrame = slotFrame[frameIndex];
+                if (previousFrame >= options.warmupFrames && previousFrame < measuredEnd) {
+                    timings[previousFrame - options.warmupFrames].gpuMs = gpuProfiler.getLatestMs(LveGpuProfiler::FRAME_ZONE);
+                }
+                slotFrame[frameIndex] = frame;
+                objectBuffer.beginFrame(frameIndex, static_cast<uint32_t>(world.size()));
+
+                GlobalUbo ubo{};
+                ubo.projection = camera.getProjection();
+                ubo.view = camera.getView();
+                pointLightSystem.update(frameInfo, ubo);
+                uboBuffers[frameIndex]->writeToBuffer(&ubo);
+                uboBuffers[frameIndex]->flush();
+
+                if (gpuCullSystem) simpleRenderSystem.cullGameObjects(frameInfo, *gpuCullSystem, depthPyramid != nullptr);
+                VkSubpassContents contents = secondaryRecorder ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+                renderer.beginSwapChainRenderPass(commandBuffer, contents);
+                if (secondaryRecorder) {
+                    secondaryRecorder->beginFrame(frameIndex, renderer.getRenderPassInheritance(), renderer.getSwapChainExtent());
+                }
+                simpleRenderSystem.renderGameObjects(frameInfo);
+                if (depthPyramid) {
+                    if (secondaryRecorder) secondaryRecorder->execute(commandBuffer);
+                    renderer.endSwapChainRenderPass(commandBuffer);
+                    depthPyramid->build(commandBuffer, frameIndex, gpuProfiler, renderer.getDepthImageView(), renderer.getSwapChainExtent());
+                    HiZInput hiZ{};
+                    hiZ.view = depthPyramid->getView();
+                    hiZ.layout = depthPyramid->getLayout();
+                    hiZ.extent = depthPyramid->getExtent();
+                    hiZ.mipCount = depthPyramid->getMipCount();
+                    hiZ.viewProjection = camera.getProjection() * camera.getView();
+                    gpuCullSystem->setHiZ(hiZ);
+                    simpleRenderSystem.cullOccludedGameObjects(frameInfo, *gpuCullSystem);
+                    renderer.resumeSwapChainRenderPass(commandBuffer, contents);
+                    simpleRenderSystem.renderOccludedGameObjects(frameInfo);
+                }
+                pointLightSystem.render(frameInfo);
+                if (secondaryRecorder) secondaryRecorder->execute(commandBuffer);
+                renderer.endSwapChainRenderPass(commandBuffer);
+                gpuProfiler.endFrame(commandBuffer);
+                float recordMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+                renderer.endFrame();
+
+                auto newLoopTime = std::chrono::steady_clock::now();
+                if (frame >= options.warmupFrames && frame < measuredEnd) {
+                    auto &timing = timings[frame - options.warmupFrames];
+                    timing.cpuFrameMs = std::chrono::duration<float, std::milli>(newLoopTime - loopTime).count();
+                    timing.cpuRecordMs = recordMs;
+                    timing.fenceWaitMs = renderer.getLastFrameWaits().fenceMs;
+                    timing.acquireWaitMs = renderer.getLastFrameWaits().acquireMs;
+                    timing.presentWaitMs = renderer.getLastFrameWaits().presentMs;
+                }
+                loopTime = newLoopTime;
+
+                if (frame + 1 == measuredEnd && !options.screenshotFile.empty()) {
+                    // stalls, only after the last measured frame was submitted
+                    if (!renderer.getOffscreenTarget()) {
+                        std::cerr << "--screenshot needs --headless" << std::endl;
+                    } else if (!renderer.getOffscreenTarget()->saveImage(options.screenshotFile)) {
+                        std::cerr << "failed to write " << options.screenshotFile << std::endl;
+                    }
+                }
+                frame++;
+            }
+            vkDeviceWaitIdle(device.device());
+
+            if (!writeResults(options, device.properties.deviceName, renderer.getSettings(), timings, gpuProfiler, indirectBuffer != nullptr, gpuCullSystem != nullptr, depthPyramid != nullptr)) {
+                throw std::runtime_error("failed to write " + options.outFile);
+            }
+            std::cout << "results written to " << options.outFile << "\n" << gpuProfiler.report();
+
+            // models defer freeing their mesh ranges, run those before meshPool is destroyed
+            world.clear();
+            device.deletionQueue().flushAll();
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options{};
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        runBench(options);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+#include "lve_bench_scenes.hpp"
+#include "baseTerrain.hpp"
+#include "lve_frame_info.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <iterator>
+
+namespace lve {
+
+    // rotation for LveCamera::setViewYXZ looking from position at target (y points down)
+    static glm::vec3 lookAtRotation(glm::vec3 position, glm::vec3 target) {
+        glm::vec3 direction = glm::normalize(target - position);
+        return {std::asin(-direction.y), std::atan2(direction.x, direction.z), 0.f};
+    }
+
+    // one full circle around center, the yaw keeps increasing so the spline never wraps around
+    static void addOrbit(LveCameraPath &path, glm::vec3 center, float radius, float height, float duration) {
+        constexpr int KEYS = 16;
+        float previousYaw = 0.f;
+        for (int i = 0; i <= KEYS; i++) {
+            float angle = glm::two_pi<float>() * i / KEYS;
+            glm::vec3 position = center + glm::vec3{radius * std::sin(angle), height, -radius * std::cos(angle)};
+            glm::vec3 rotation = lookAtRotation(position, center);
+            while (i > 0 && rotation.y < previousYaw - glm::pi<float>()) rotation.y += glm::two_pi<float>();
+            while (i > 0 && rotation.y > previousYaw + glm::pi<float>()) rotation.y -= glm::two_pi<float>();
+            previousYaw = rotation.y;
+            path.addKey(duration * i / KEYS, position, rotation);
+        }
+    }
+
+    // fully saturated color around the hue circle, hue in [0, 1)
+    static glm::vec3 hueColor(float hue) {
+        auto channel = [hue](float offset) {
+            float h = std::fmod(hue * 6.f + offset, 6.f);
+            return glm::clamp(std::abs(h - 3.f) - 1.f, 0.f, 1.f);
+        };
+        return {channel(0.f), channel(4.f), channel(2.f)};
+    }
+
+    static void loadTerrain(LveDevice &device, LveUploadBatch &uploadBatch, LveMeshPool &meshPool, LveWorld &world, LveCameraPath &cameraPath) {
+        BaseTerrain terrain("./data/heightmap.save");
+        TransformComponent terrainTransform{};
+        terrainTransform.setScale({0.03f, 0.01f, 0.03f});
+        terrainTransform.setTranslation({-5.f, -0.5f, -5.f});
+        terrainTransform.setStatic(true);
+        world.createEntity(
+            std::move(terrainTransform),
+            MeshComponent{LveModel::loadHeightMap(device, terrain.terrainData, &uploadBatch, &meshPool)});
+
+        createPointLight(world, {-1.f, -2.f, -1.f}, 4.f);
+
+        // low pass over the terrain and a climb at the end that looks back over all of it
+        const glm::vec3 positions[] = {
+            {-5.5f, -1.0f, -5.5f}, {-3.f, -0.8f, -3.5f}, {-1.f, -0.9f, -1.f}, {1.f, -0.8f, 0.5f},
+            {2.5f, -1.2f, 2.5f}, {1.f, -2.5f, 3.5f}, {-2.f, -3.f, 2.f}};
+        const glm::vec3 target{-1.2f, 0.f, -1.2f};
+        for (size_t i = 0; i < std::size(positions); i++) {
+            cameraPath.addKey(2.f * i, positions[i], lookAtRotation(positions[i], target));
+        }
+    }
+
+    static void loadVases(LveDevice &device, LveUploadBatch &uploadBatch, LveMeshPool &meshPool, LveWorld &world, LveCameraPath &cameraPath) {
+        std::shared_ptr<LveModel> smoothVase = LveModel::createModelFromFile(device, "./models/smooth_vase.obj", &uploadBatch, &meshPool);
+        std::shared_ptr<LveModel> flatVase = LveModel::createModelFromFile(device, "./models/flat_vase.obj", &uploadBatch, &meshPool);
+
+        constexpr int GRID = 32;
+        constexpr float SPACING = 0.5f;
+        for (int z = 0; z < GRID; z++) {
+            for (int x = 0; x < GRID; x++) {
+                TransformComponent transform{};
+                transform.setTranslation({(x - GRID / 2) * SPACING, .5f, (z - GRID / 2) * SPACING});
+                transform.setRotation({0.f, 0.1f * (x * 7 + z * 3), 0.f});
+                transform.setScale(glm::vec3{1.f});
+                transform.setStatic(true);
+                world.createEntity(std::move(transform), MeshComponent{(x + z) % 2 ? flatVase : smoothVase});
+            }
+        }
+
+        createPointLight(world, {0.f, -3.f, 0.f}, 20.f);
+
+        addOrbit(cameraPath, {0.f, 0.f, 0.f}, 11.f, -4.f, 12.f);
+    }
+
+    static void loadLights(LveDevice &device, LveUploadBatch &uploadBatch, LveMeshPool &meshPool, LveWorld &world, LveCameraPath &cameraPath) {
+        std::shared_ptr<LveModel> quad = LveModel::createModelFromFile(device, "./models/quad.obj", &uploadBatch, &meshPool);
+        std::shared_ptr<LveModel> smoothVase = LveModel::createModelFromFile(device, "./models/smooth_vase.obj", &uploadBatch, &meshPool);
+
+        TransformComponent floorTransform{};
+        floorTransform.setTranslation({0.f, .5f, 0.f});
+        floorTransform.setScale({6.f, 1.f, 6.f});
+        floorTransform.setStatic(true);
+        world.createEntity(std::move(floorTransform), MeshComponent{quad});
+
+        constexpr int GRID = 8;
+        for (int z = 0; z < GRID; z++) {
+            for (int x = 0; x < GRID; x++) {
+                TransformComponent transform{};
+                transform.setTranslation({(x - GRID / 2 + .5f) * 1.2f, .5f, (z - GRID / 2 + .5f) * 1.2f});
+                transform.setScale(glm::vec3{2.f});
+                transform.setStatic(true);
+                world.createEntity(std::move(transform), MeshComponent{smoothVase});
+            }
+        }
+
+        // every light the ubo can hold, on two rings at different heights
+        for (int i = 0; i < MAX_LIGHTS; i++) {
+            float angle = glm::two_pi<float>() * i / MAX_LIGHTS;
+            float radius = i % 2 ? 2.5f : 4.5f;
+            createPointLight(
+                world,
+                {radius * std::sin(angle), i % 2 ? -0.4f : -1.f, radius * std::cos(angle)},
+                0.6f,
+                0.05f,
+                hueColor(static_cast<float>(i) / MAX_LIGHTS));
+        }
+
+        addOrbit(cameraPath, {0.f, 0.f, 0.f}, 7.f, -3.f, 10.f);
+    }
+
+    // draw call bound: one small cube per object, ~50k draws
+    static void loadCubes(LveDevice &device, LveUploadBatch &uploadBatch, LveMeshPool &meshPool, LveWorld &world, LveCameraPath &cameraPath) {
+        std::shared_ptr<LveModel> cube = LveModel::createModelFromFile(device, "./models/colored_cube.obj", &uploadBatch, &meshPool);
+
+        constexpr int GRID = 224;
+        constexpr float SPACING = 0.1f;
+        for (int z = 0; z < GRID; z++) {
+            for (int x = 0; x < GRID; x++) {
+                TransformComponent transform{};
+                transform.setTranslation({(x - GRID / 2) * SPACING, .5f - 0.02f * ((x * 13 + z * 7) % 5), (z - GRID / 2) * SPACING});
+                transform.setScale(glm::vec3{0.03f});
+                transform.setStatic(true);
+                world.createEntity(std::move(transform), MeshComponent{cube});
+            }
+        }
+
+        createPointLight(world, {0.f, -3.f, 0.f}, 20.f);
+
+        addOrbit(cameraPath, {0.f, 0.f, 0.f}, 14.f, -6.f, 12.f);
+    }
+
+    // instancing bound: ~100k props sharing two models, scattered without randomness
+    static void loadProps(LveDevice &device, LveUploadBatch &uploadBatch, LveMeshPool &meshPool, LveWorld &world, LveCameraPath &cameraPath) {
+        std::shared_ptr<LveModel> rock = LveModel::createModelFromFile(device, "./models/cube.obj", &uploadBatch, &meshPool);
+        std::shared_ptr<LveModel> tree = LveModel::createModelFromFile(device, "./models/flat_vase.obj", &uploadBatch, &meshPool);
+
+        constexpr int GRID = 316;
+        constexpr float SPACING = 0.12f;
+        for (int z = 0; z < GRID; z++) {
+            for (int x = 0; x < GRID; x++) {
+                // a cheap integer hash gives every prop its own offset, rotation and size
+                uint32_t hash = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(z) * 19349663u;
+                float jitterX = ((hash & 0xff) / 255.f - .5f) * SPACING;
+                float jitterZ = (((hash >> 8) & 0xff) / 255.f - .5f) * SPACING;
+                bool isTree = ((hash >> 16) & 3) == 0;
+
+                TransformComponent transform{};
+                transform.setTranslation({(x - GRID / 2) * SPACING + jitterX, .5f, (z - GRID / 2) * SPACING + jitterZ});
+                transform.setRotation({0.f, ((hash >> 20) & 0xff) / 255.f * glm::two_pi<float>(), 0.f});
+                float size = 0.5f + ((hash >> 28) & 0xf) / 15.f;
+                transform.setScale(isTree ? glm::vec3{0.3f * size} : glm::vec3{0.02f * size});
+                transform.setStatic(true);
+                world.createEntity(std::move(transform), MeshComponent{isTree ? tree : rock});
+            }
+        }
+
+        createPointLight(world, {0.f, -4.f, 0.f}, 30.f);
+
+        addOrbit(cameraPath, {0.f, 0.f, 0.f}, 16.f, -5.f, 12.f);
+    }
+
+    std::vector<std::string> benchSceneNames() {
+        return {"terrain", "vases", "lights", "cubes", "props"};
+    }
+
+    bool loadBenchScene(
+        const std::string &name,
+        LveDevice &device,
+        LveUploadBatch &uploadBatch,
+        LveMeshPool &meshPool,
+        LveWorld &world,
+        LveCameraPath &cameraPath) {
+        if (name == "terrain") {
+            loadTerrain(device, uploadBatch, meshPool, world, cameraPath);
+        } else if (name == "vases") {
+            loadVases(device, uploadBatch, meshPool, world, cameraPath);
+        } else if (name == "lights") {
+            loadLights(device, uploadBatch, meshPool, world, cameraPath);
+        } else if (name == "cubes") {
+            loadCubes(device, uploadBatch, meshPool, world, cameraPath);
+        } else if (name == "props") {
+            loadProps(device, uploadBatch, meshPool, world, cameraPath);
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "lve_camera_path.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_upload_batch.hpp"
+
+#include <string>
+#include <vector>
+
+namespace lve {
+
+    // every scene is built without randomness, so runs on different builds see the same frames
+    std::vector<std::string> benchSceneNames();
+
+    // fills world and the scene's default camera path, returns false for an unknown name
+    bool loadBenchScene(
+        const std::string &name,
+        LveDevice &device,
+        LveUploadBatch &uploadBatch,
+        LveMeshPool &meshPool,
+        LveWorld &world,
+        LveCameraPath &cameraPath);
+}
@@ -49,12 +49,14 @@ LveBuffer::LveBuffer(
 LveBuffer::~LveBuffer() {
   unmap();
   vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-  vkFreeMemory(lveDevice.device(), memory, nullptr);
+  lveDevice.allocator().free(memory);
 }
 
 /**
  * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
  *
+ * @note Host visible blocks stay mapped by the allocator, so this only computes the pointer
+ *
  * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
  * buffer range.
  * @param offset (Optional) Byte offset from beginning
@@ -62,21 +64,20 @@ LveBuffer::~LveBuffer() {
  * @return VkResult of the buffer mapping call
  */
 VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-  assert(buffer && memory && "Called map on buffer before create");
-  return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+  assert(buffer && memory.isValid() && "Called map on buffer before create");
+  if (memory.mapped == nullptr) {
+    return VK_ERROR_MEMORY_MAP_FAILED;
+  }
+  mapped = static_cast<char *>(memory.mapped) + offset;
+  return VK_SUCCESS;
 }
 
 /**
  * Unmap a mapped memory range
  *
- * @note Does not return a result as vkUnmapMemory can't fail
+ * @note The block itself stays mapped until the allocator releases it
  */
-void LveBuffer::unmap() {
-  if (mapped) {
-    vkUnmapMemory(lveDevice.device(), memory);
-    mapped = nullptr;
-  }
-}
+void LveBuffer::unmap() { mapped = nullptr; }
 
 /**
  * Copies the specified data to the mapped buffer. Default value writes whole buffer range
@@ -111,12 +112,7 @@ void LveBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset
  * @return VkResult of the flush call
  */
 VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
-  return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+  return lveDevice.allocator().flush(memory, size, offset);
 }
 
 /**
@@ -131,12 +127,7 @@ VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
  * @return VkResult of the invalidate call
  */
 VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
-  return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
+  return lveDevice.allocator().invalidate(memory, size, offset);
 }
 
 /**
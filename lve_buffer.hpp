@@ -35,7 +35,7 @@ class LveBuffer {
   void* getMappedMemory() const { return mapped; }
   uint32_t getInstanceCount() const { return instanceCount; }
   VkDeviceSize getInstanceSize() const { return instanceSize; }
-  VkDeviceSize getAlignmentSize() const { return instanceSize; }
+  VkDeviceSize getAlignmentSize() const { return alignmentSize; }
   VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
   VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
   VkDeviceSize getBufferSize() const { return bufferSize; }
@@ -46,7 +46,7 @@ class LveBuffer {
   LveDevice& lveDevice;
   void* mapped = nullptr;
   VkBuffer buffer = VK_NULL_HANDLE;
-  VkDeviceMemory memory = VK_NULL_HANDLE;
+  LveAllocation memory{};
 
   VkDeviceSize bufferSize;
   uint32_t instanceCount;
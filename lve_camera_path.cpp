@@ -0,0 +1,98 @@
+#include "lve_camera_path.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+namespace lve {
+
+namespace {
+
+glm::vec3 catmullRom(
+    const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t) {
+  float t2 = t * t;
+  float t3 = t2 * t;
+  return 0.5f * ((2.f * p1) + (-p0 + p2) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 +
+                 (-p0 + 3.f * p1 - 3.f * p2 + p3) * t3);
+}
+
+}  // namespace
+
+void LveCameraPath::addKey(float time, const glm::vec3 &position, const glm::vec3 &rotation) {
+  assert((keys.empty() || time > keys.back().time) && "Camera path keys must be in time order");
+  keys.push_back({time, position, rotation});
+}
+
+void LveCameraPath::sample(float time, glm::vec3 &position, glm::vec3 &rotation) const {
+  assert(!keys.empty() && "Cannot sample an empty camera path");
+  if (keys.size() == 1 || time <= keys.front().time) {
+    position = keys.front().position;
+    rotation = keys.front().rotation;
+    return;
+  }
+  if (time >= keys.back().time) {
+    position = keys.back().position;
+    rotation = keys.back().rotation;
+    return;
+  }
+
+  // the segment [k1, k2] containing time, the end keys are repeated as outer control points
+  auto next = std::upper_bound(
+      keys.begin(),
+      keys.end(),
+      time,
+      [](float value, const Key &key) { return value < key.time; });
+  size_t k2 = static_cast<size_t>(next - keys.begin());
+  size_t k1 = k2 - 1;
+  size_t k0 = k1 > 0 ? k1 - 1 : k1;
+  size_t k3 = std::min(k2 + 1, keys.size() - 1);
+
+  float t = (time - keys[k1].time) / (keys[k2].time - keys[k1].time);
+  position = catmullRom(keys[k0].position, keys[k1].position, keys[k2].position, keys[k3].position, t);
+  rotation = catmullRom(keys[k0].rotation, keys[k1].rotation, keys[k2].rotation, keys[k3].rotation, t);
+}
+
+bool LveCameraPath::loadFromFile(const std::string &filePath) {
+  std::ifstream file{filePath};
+  if (!file) {
+    return false;
+  }
+
+  std::vector<Key> loaded;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream values{line};
+    Key key{};
+    if (!(values >> key.time >> key.position.x >> key.position.y >> key.position.z >>
+          key.rotation.x >> key.rotation.y >> key.rotation.z)) {
+      return false;
+    }
+    if (!loaded.empty() && key.time <= loaded.back().time) {
+      return false;
+    }
+    loaded.push_back(key);
+  }
+  keys = std::move(loaded);
+  return !keys.empty();
+}
+
+bool LveCameraPath::saveToFile(const std::string &filePath) const {
+  std::ofstream file{filePath};
+  if (!file) {
+    return false;
+  }
+  file << "# time px py pz rx ry rz\n";
+  file.precision(9);
+  for (auto &key : keys) {
+    file << key.time << ' ' << key.position.x << ' ' << key.position.y << ' ' << key.position.z
+         << ' ' << key.rotation.x << ' ' << key.rotation.y << ' ' << key.rotation.z << '\n';
+  }
+  return static_cast<bool>(file);
+}
+
+}  // namespace lve
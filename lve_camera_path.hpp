@@ -0,0 +1,46 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Camera keyframes interpolated with a Catmull-Rom spline.
+ *
+ * Keys hold a position and a yxz rotation (as used by LveCamera::setViewYXZ) at a point in time.
+ * Sampling is a pure function of time, so replaying with a fixed timestep gives the same camera on
+ * every run. The file format is one key per line: time px py pz rx ry rz.
+ */
+class LveCameraPath {
+ public:
+  struct Key {
+    float time;
+    glm::vec3 position;
+    glm::vec3 rotation;
+  };
+
+  // keys have to be added in increasing time order
+  void addKey(float time, const glm::vec3 &position, const glm::vec3 &rotation);
+  void clear() { keys.clear(); }
+
+  // clamps to the first and last key outside the path
+  void sample(float time, glm::vec3 &position, glm::vec3 &rotation) const;
+
+  bool empty() const { return keys.empty(); }
+  size_t keyCount() const { return keys.size(); }
+  float getDuration() const { return keys.empty() ? 0.f : keys.back().time - keys.front().time; }
+
+  bool loadFromFile(const std::string &filePath);
+  bool saveToFile(const std::string &filePath) const;
+
+ private:
+  std::vector<Key> keys;
+};
+
+}  // namespace lve
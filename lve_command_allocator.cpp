@@ -0,0 +1,85 @@
+#include "lve_command_allocator.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+LveCommandAllocator::LveCommandAllocator(
+    LveDevice &device, uint32_t frameCount, uint32_t threadCount)
+    : lveDevice{device}, frameCount{frameCount}, threadCount{threadCount} {
+  createPools();
+}
+
+LveCommandAllocator::~LveCommandAllocator() { destroyPools(); }
+
+void LveCommandAllocator::createPools() {
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+  // no RESET_COMMAND_BUFFER_BIT, buffers are only ever reset together with their pool
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+  pools.resize(frameCount * threadCount);
+  for (auto &pool : pools) {
+    if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &pool.commandPool) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create frame command pool!");
+    }
+  }
+}
+
+void LveCommandAllocator::destroyPools() {
+  // destroying a pool frees its command buffers
+  for (auto &pool : pools) {
+    vkDestroyCommandPool(lveDevice.device(), pool.commandPool, nullptr);
+  }
+  pools.clear();
+}
+
+void LveCommandAllocator::setFrameCount(uint32_t count) {
+  if (count == frameCount) {
+    return;
+  }
+  destroyPools();
+  frameCount = count;
+  currentFrame = 0;
+  createPools();
+}
+
+void LveCommandAllocator::beginFrame(int frameIndex) {
+  assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+  currentFrame = frameIndex;
+  for (uint32_t i = 0; i < threadCount; i++) {
+    auto &pool = pools[frameIndex * threadCount + i];
+    if (pool.used[0] == 0 && pool.used[1] == 0) {
+      continue;
+    }
+    vkResetCommandPool(lveDevice.device(), pool.commandPool, 0);
+    pool.used[0] = 0;
+    pool.used[1] = 0;
+  }
+}
+
+VkCommandBuffer LveCommandAllocator::allocate(uint32_t threadIndex, VkCommandBufferLevel level) {
+  assert(threadIndex < threadCount && "Thread index out of range");
+  auto &pool = pools[currentFrame * threadCount + threadIndex];
+  auto &commandBuffers = pool.commandBuffers[level];
+  uint32_t &used = pool.used[level];
+  if (used == commandBuffers.size()) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = level;
+    allocInfo.commandPool = pool.commandPool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate frame command buffer!");
+    }
+    commandBuffers.push_back(commandBuffer);
+  }
+  return commandBuffers[used++];
+}
+
+}  // namespace lve
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <vector>
+
+namespace lve {
+
+/*
+ * Command buffers that live for one frame, from pools that are reset as a whole.
+ *
+ * Every (frame in flight, thread) pair owns a transient command pool, so a thread never shares a
+ * pool with another one and no pool is touched by the GPU and the CPU at the same time. beginFrame
+ * resets the frame's pools with a single vkResetCommandPool each instead of resetting every
+ * buffer on begin. Buffers are kept after a reset and handed out again the next time the frame
+ * comes around.
+ */
+class LveCommandAllocator {
+ public:
+  LveCommandAllocator(LveDevice &device, uint32_t frameCount, uint32_t threadCount = 1);
+  ~LveCommandAllocator();
+
+  LveCommandAllocator(const LveCommandAllocator &) = delete;
+  LveCommandAllocator &operator=(const LveCommandAllocator &) = delete;
+
+  // recreates the pools, only while no frame is in flight
+  void setFrameCount(uint32_t count);
+
+  // resets the frame's pools, the frame's fence must have been waited on
+  void beginFrame(int frameIndex);
+  // a buffer in the initial state from the current frame's pool of threadIndex. Only that thread
+  // may call this for its index between two beginFrame calls
+  VkCommandBuffer allocate(uint32_t threadIndex, VkCommandBufferLevel level);
+
+  uint32_t getFrameCount() const { return frameCount; }
+  uint32_t getThreadCount() const { return threadCount; }
+
+ private:
+  struct Pool {
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    // indexed by VkCommandBufferLevel
+    std::vector<VkCommandBuffer> commandBuffers[2];
+    uint32_t used[2]{};
+  };
+
+  void createPools();
+  void destroyPools();
+
+  LveDevice &lveDevice;
+  uint32_t frameCount;
+  uint32_t threadCount;
+
+  // indexed by frameIndex * threadCount + threadIndex
+  std::vector<Pool> pools;
+  int currentFrame = 0;
+};
+
+}  // namespace lve
@@ -0,0 +1,57 @@
+#include "lve_compute_pipeline.hpp"
+
+#include "lve_pipeline.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+LveComputePipeline::LveComputePipeline(
+    LveDevice &device, const std::string &compFilepath, VkPipelineLayout pipelineLayout)
+    : lveDevice{device} {
+  assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout");
+  auto code = LvePipeline::readFile(compFilepath);
+
+  VkShaderModuleCreateInfo moduleInfo{};
+  moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleInfo.codeSize = code.size();
+  moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+  if (vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &compShaderModule) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create compute shader module: " + compFilepath);
+  }
+
+  VkPipelineShaderStageCreateInfo stageInfo{};
+  stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  stageInfo.module = compShaderModule;
+  stageInfo.pName = "main";
+
+  VkComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.stage = stageInfo;
+  pipelineInfo.layout = pipelineLayout;
+  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+  pipelineInfo.basePipelineIndex = -1;
+
+  if (vkCreateComputePipelines(
+          lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) !=
+      VK_SUCCESS) {
+    vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+    throw std::runtime_error("failed to create compute pipeline: " + compFilepath);
+  }
+}
+
+LveComputePipeline::~LveComputePipeline() {
+  vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+  vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+}
+
+void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+}
+
+}  // namespace lve
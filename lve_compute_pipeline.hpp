@@ -0,0 +1,34 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <string>
+
+namespace lve {
+
+/*
+ * A compute pipeline built from a single SPIR-V shader.
+ *
+ * LvePipeline only covers the graphics stages, compute work (culling, depth reductions) goes
+ * through this class instead. As with LvePipeline the layout belongs to the system that owns the
+ * pipeline, so it can share descriptor set layouts with its graphics pipelines.
+ */
+class LveComputePipeline {
+ public:
+  LveComputePipeline(
+      LveDevice &device, const std::string &compFilepath, VkPipelineLayout pipelineLayout);
+  ~LveComputePipeline();
+
+  LveComputePipeline(const LveComputePipeline &) = delete;
+  LveComputePipeline &operator=(const LveComputePipeline &) = delete;
+
+  void bind(VkCommandBuffer commandBuffer);
+
+ private:
+  LveDevice &lveDevice;
+  VkPipeline computePipeline = VK_NULL_HANDLE;
+  VkShaderModule compShaderModule = VK_NULL_HANDLE;
+};
+
+}  // namespace lve
@@ -0,0 +1,118 @@
+// Microbenchmark of LveFrustumCuller: culls a fixed random field of spheres and boxes with every
+// path the CPU supports, on one thread, and prints the tests per second of each.
+//
+//   lve_cull_bench --objects 100000 --iterations 200
+
+#include "lve_camera.hpp"
+#include "lve_frustum_culler.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // the per core throughput a frame's worth of culling is budgeted with
+    constexpr double TARGET_TESTS_PER_SECOND = 20e6;
+
+    struct Options {
+        uint32_t objects = 100000;
+        uint32_t iterations = 200;
+    };
+
+    bool parseArgs(int argc, char *argv[], Options &options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--objects") options.objects = std::stoul(value());
+            else if (arg == "--iterations") options.iterations = std::stoul(value());
+            else return false;
+        }
+        return options.objects > 0 && options.iterations > 0;
+    }
+
+    // returns the visible count of the last iteration
+    template <typename Cull>
+    uint32_t measure(const char *name, const Options &options, Cull cull) {
+        uint32_t visibleCount = cull();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < options.iterations; i++) {
+            visibleCount = cull();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double testsPerSecond = static_cast<double>(options.objects) * options.iterations / seconds;
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << testsPerSecond / 1e6 << " M tests/s  "
+                  << std::setw(8) << seconds * 1e3 / options.iterations << " ms/iteration  "
+                  << visibleCount << " visible"
+                  << (testsPerSecond < TARGET_TESTS_PER_SECOND ? "  (below target)" : "") << "\n";
+        return visibleCount;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    using namespace lve;
+    Options options{};
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            std::cout << "usage: lve_cull_bench [--objects n] [--iterations n]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // a fixed seed, every run culls the same field
+    std::mt19937 random{1234};
+    std::uniform_real_distribution<float> position{-100.f, 100.f};
+    std::uniform_real_distribution<float> size{0.25f, 2.f};
+    LveBoundsTable bounds;
+    bounds.reserve(options.objects);
+    for (uint32_t i = 0; i < options.objects; i++) {
+        glm::vec3 halfExtent{size(random), size(random), size(random)};
+        bounds.add({position(random), position(random), position(random)}, glm::length(halfExtent), halfExtent);
+    }
+
+    LveCamera camera{};
+    camera.setViewYXZ(glm::vec3{0.f}, glm::vec3{0.f, 0.5f, 0.f});
+    camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, 0.1f, 100.f);
+    LveFrustum frustum = LveFrustum::fromViewProjection(camera.getProjection() * camera.getView());
+
+    std::cout << options.objects << " objects, " << options.iterations << " iterations, target "
+              << TARGET_TESTS_PER_SECOND / 1e6 << " M tests/s per core\n";
+    std::vector<uint32_t> visible;
+    bool mismatch = false;
+    for (bool boxes : {false, true}) {
+        uint32_t scalarCount = 0;
+        for (auto path : {LveFrustumCuller::Path::Scalar, LveFrustumCuller::Path::Sse, LveFrustumCuller::Path::Avx2}) {
+            if (!LveFrustumCuller::isSupported(path)) continue;
+            std::string name = std::string{boxes ? "boxes " : "spheres "} + LveFrustumCuller::pathName(path);
+            uint32_t count = measure(name.c_str(), options, [&]() {
+                return boxes ? LveFrustumCuller::cullBoxes(frustum, bounds, visible, path)
+                             : LveFrustumCuller::cullSpheres(frustum, bounds, visible, path);
+            });
+            if (path == LveFrustumCuller::Path::Scalar) scalarCount = count;
+            // FMA can only move bounds that touch a plane to the other side
+            else if (count > scalarCount + options.objects / 10000 + 1 || count + options.objects / 10000 + 1 < scalarCount) mismatch = true;
+        }
+    }
+    if (mismatch) {
+        std::cerr << "the simd paths disagree with the scalar one" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace lve {
+
+/*
+ * Defers destruction of GPU resources until no frame in flight can still reference them.
+ *
+ * Deleters pushed while frame N is current run at the start of frame N + framesInFlight, which is
+ * the first point where the renderer has waited on the fence covering frame N.
+ */
+class LveDeletionQueue {
+ public:
+  LveDeletionQueue() = default;
+  ~LveDeletionQueue() { flushAll(); }
+
+  LveDeletionQueue(const LveDeletionQueue &) = delete;
+  LveDeletionQueue &operator=(const LveDeletionQueue &) = delete;
+
+  void push(std::function<void()> &&deleter) {
+    pending.emplace_back(currentFrame + framesInFlight, std::move(deleter));
+  }
+
+  // call after waiting on the fence of frameNumber's frame slot
+  void beginFrame(uint64_t frameNumber) {
+    currentFrame = frameNumber;
+    while (!pending.empty() && pending.front().first <= frameNumber) {
+      auto deleter = std::move(pending.front().second);
+      pending.pop_front();
+      deleter();
+    }
+  }
+
+  // only once the device is idle
+  void flushAll() {
+    while (!pending.empty()) {
+      auto deleter = std::move(pending.front().second);
+      pending.pop_front();
+      deleter();
+    }
+  }
+
+  void setFramesInFlight(uint32_t count) { framesInFlight = count; }
+  size_t size() const { return pending.size(); }
+
+ private:
+  std::deque<std::pair<uint64_t, std::function<void()>>> pending;
+  uint64_t currentFrame = 0;
+  uint32_t framesInFlight = 2;
+};
+
+}  // namespace lve
@@ -0,0 +1,324 @@
+#include "lve_depth_pyramid.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+uint32_t previousPow2(uint32_t value) {
+  uint32_t result = 1;
+  while (result * 2 <= value) {
+    result *= 2;
+  }
+  return result;
+}
+
+}  // namespace
+
+LveDepthPyramid::LveDepthPyramid(LveDevice &device, uint32_t frameCount)
+    : lveDevice{device}, frameCount{frameCount} {
+  setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                  .addBinding(
+                      0,
+                      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                      VK_SHADER_STAGE_COMPUTE_BIT)
+                  .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+                  .build();
+  createPipelineLayout();
+  reducePipeline = std::make_unique<LveComputePipeline>(
+      lveDevice,
+      "shaders/depth_reduce.comp.spv",
+      pipelineLayout);
+  createSampler();
+}
+
+LveDepthPyramid::~LveDepthPyramid() {
+  // the owner waits for the device before destroying it, nothing is in flight anymore
+  for (auto levelView : levelViews) {
+    vkDestroyImageView(lveDevice.device(), levelView, nullptr);
+  }
+  if (view != VK_NULL_HANDLE) {
+    vkDestroyImageView(lveDevice.device(), view, nullptr);
+    vkDestroyImage(lveDevice.device(), image, nullptr);
+    lveDevice.allocator().free(imageMemory);
+  }
+  descriptorPool.reset();
+  vkDestroySampler(lveDevice.device(), sampler, nullptr);
+  vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+}
+
+void LveDepthPyramid::createPipelineLayout() {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(PushConstants);
+
+  VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+  }
+}
+
+void LveDepthPyramid::createSampler() {
+  // the shader fetches texels, filtering never applies
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_NEAREST;
+  samplerInfo.minFilter = VK_FILTER_NEAREST;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.minLod = 0.f;
+  samplerInfo.maxLod = 0.f;
+  if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid sampler!");
+  }
+}
+
+void LveDepthPyramid::setFrameCount(uint32_t count) {
+  if (count == frameCount) {
+    return;
+  }
+  frameCount = count;
+  if (isValid()) {
+    createDescriptorSets();
+  }
+}
+
+void LveDepthPyramid::createPyramid(VkExtent2D newDepthExtent) {
+  destroyPyramid();
+  depthExtent = newDepthExtent;
+  extent = {previousPow2(depthExtent.width), previousPow2(depthExtent.height)};
+  mipCount = 1;
+  while (mipCount < MAX_LEVELS && ((extent.width >> mipCount) > 0 || (extent.height >> mipCount) > 0)) {
+    mipCount++;
+  }
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent = {extent.width, extent.height, 1};
+  imageInfo.mipLevels = mipCount;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = VK_FORMAT_R32_SFLOAT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  lveDevice.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      image,
+      imageMemory);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = VK_FORMAT_R32_SFLOAT;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = mipCount;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid view!");
+  }
+
+  levelViews.resize(mipCount);
+  viewInfo.subresourceRange.levelCount = 1;
+  for (uint32_t level = 0; level < mipCount; level++) {
+    viewInfo.subresourceRange.baseMipLevel = level;
+    if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &levelViews[level]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create depth pyramid level view!");
+    }
+  }
+
+  createDescriptorSets();
+}
+
+void LveDepthPyramid::destroyPyramid() {
+  if (view == VK_NULL_HANDLE) {
+    return;
+  }
+  // frames in flight may still sample the old pyramid
+  LveDevice *device = &lveDevice;
+  VkImage oldImage = image;
+  LveAllocation oldMemory = imageMemory;
+  VkImageView oldView = view;
+  std::vector<VkImageView> oldLevelViews = std::move(levelViews);
+  std::shared_ptr<LveDescriptorPool> oldPool = std::move(descriptorPool);
+  lveDevice.deletionQueue().push(
+      [device, oldImage, oldMemory, oldView, oldLevelViews, oldPool]() mutable {
+        for (auto levelView : oldLevelViews) {
+          vkDestroyImageView(device->device(), levelView, nullptr);
+        }
+        vkDestroyImageView(device->device(), oldView, nullptr);
+        vkDestroyImage(device->device(), oldImage, nullptr);
+        device->allocator().free(oldMemory);
+      });
+  image = VK_NULL_HANDLE;
+  imageMemory = {};
+  view = VK_NULL_HANDLE;
+  levelViews.clear();
+}
+
+void LveDepthPyramid::createDescriptorSets() {
+  // the old pool may still be bound by frames in flight
+  if (descriptorPool) {
+    std::shared_ptr<LveDescriptorPool> oldPool = std::move(descriptorPool);
+    lveDevice.deletionQueue().push([oldPool]() {});
+  }
+  uint32_t setCount = frameCount + mipCount - 1;
+  descriptorPool = LveDescriptorPool::Builder(lveDevice)
+                       .setMaxSets(setCount)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount)
+                       .build();
+
+  levelSets.assign(mipCount, VK_NULL_HANDLE);
+  for (uint32_t level = 1; level < mipCount; level++) {
+    VkDescriptorImageInfo inputInfo{sampler, levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+    VkDescriptorImageInfo outputInfo{VK_NULL_HANDLE, levelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+    if (!LveDescriptorWriter(*setLayout, *descriptorPool)
+             .writeImage(0, &inputInfo)
+             .writeImage(1, &outputInfo)
+             .build(levelSets[level])) {
+      throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+    }
+  }
+  depthSets.assign(frameCount, VK_NULL_HANDLE);
+  boundDepthViews.assign(frameCount, VK_NULL_HANDLE);
+}
+
+void LveDepthPyramid::updateDepthInput(int frameIndex, VkImageView depthView) {
+  if (boundDepthViews[frameIndex] == depthView) {
+    return;
+  }
+  VkDescriptorImageInfo inputInfo{
+      sampler,
+      depthView,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+  VkDescriptorImageInfo outputInfo{VK_NULL_HANDLE, levelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+  LveDescriptorWriter writer{*setLayout, *descriptorPool};
+  writer.writeImage(0, &inputInfo).writeImage(1, &outputInfo);
+  // only this frame slot uses the set and its previous submission has completed
+  if (depthSets[frameIndex] == VK_NULL_HANDLE) {
+    if (!writer.build(depthSets[frameIndex])) {
+      throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+    }
+  } else {
+    writer.overwrite(depthSets[frameIndex]);
+  }
+  boundDepthViews[frameIndex] = depthView;
+}
+
+void LveDepthPyramid::build(
+    VkCommandBuffer commandBuffer,
+    int frameIndex,
+    LveGpuProfiler &gpuProfiler,
+    VkImageView depthView,
+    VkExtent2D newDepthExtent) {
+  assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+  if (!isValid() || newDepthExtent.width != depthExtent.width ||
+      newDepthExtent.height != depthExtent.height) {
+    createPyramid(newDepthExtent);
+  }
+  updateDepthInput(frameIndex, depthView);
+
+  LveGpuZone gpuZone{gpuProfiler, commandBuffer, "depth pyramid"};
+
+  // earlier frames may still be culling against the previous contents, which are overwritten whole
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mipCount;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  reducePipeline->bind(commandBuffer);
+  VkExtent2D inputExtent = depthExtent;
+  for (uint32_t level = 0; level < mipCount; level++) {
+    VkExtent2D outputExtent{
+        std::max(extent.width >> level, 1u),
+        std::max(extent.height >> level, 1u)};
+    VkDescriptorSet descriptorSet = level == 0 ? depthSets[frameIndex] : levelSets[level];
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        pipelineLayout,
+        0,
+        1,
+        &descriptorSet,
+        0,
+        nullptr);
+    PushConstants push{};
+    push.inputSize[0] = static_cast<int32_t>(inputExtent.width);
+    push.inputSize[1] = static_cast<int32_t>(inputExtent.height);
+    push.outputSize[0] = static_cast<int32_t>(outputExtent.width);
+    push.outputSize[1] = static_cast<int32_t>(outputExtent.height);
+    vkCmdPushConstants(
+        commandBuffer,
+        pipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(PushConstants),
+        &push);
+    vkCmdDispatch(commandBuffer, (outputExtent.width + 7) / 8, (outputExtent.height + 7) / 8, 1);
+
+    // the next level, and the cull pass after the last one, read what was just written
+    barrier.subresourceRange.baseMipLevel = level;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+    inputExtent = outputExtent;
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "lve_compute_pipeline.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_gpu_profiler.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Hierarchical-Z pyramid of a depth attachment, for occlusion culling.
+ *
+ * Level 0 is the largest power of two that fits in the depth extent and every texel of every level
+ * holds the farthest depth of the texels it covers on the level above, so an object whose nearest
+ * depth lies behind that value is hidden everywhere it could show. The levels are reduced one
+ * after another in a compute shader from the render target's depth attachment, which has to be in
+ * DEPTH_STENCIL_READ_ONLY_OPTIMAL (the render pass leaves it there).
+ *
+ * The pyramid is a single R32_SFLOAT image in VK_IMAGE_LAYOUT_GENERAL shared by all frames in
+ * flight: build() waits for the compute reads of earlier frames before writing it. It is recreated
+ * when the depth extent changes, the old image goes through the deletion queue.
+ */
+class LveDepthPyramid {
+ public:
+  static constexpr uint32_t MAX_LEVELS = 16;
+
+  LveDepthPyramid(LveDevice &device, uint32_t frameCount);
+  ~LveDepthPyramid();
+
+  LveDepthPyramid(const LveDepthPyramid &) = delete;
+  LveDepthPyramid &operator=(const LveDepthPyramid &) = delete;
+
+  // reallocates the per frame descriptor sets, only while no frame is in flight
+  void setFrameCount(uint32_t count);
+  // records the reduction of depthView outside a render pass, compute shaders can sample the
+  // pyramid right after
+  void build(
+      VkCommandBuffer commandBuffer,
+      int frameIndex,
+      LveGpuProfiler &gpuProfiler,
+      VkImageView depthView,
+      VkExtent2D depthExtent);
+
+  // false until the first build
+  bool isValid() const { return view != VK_NULL_HANDLE; }
+  // all levels, for textureLod
+  VkImageView getView() const { return view; }
+  VkImageLayout getLayout() const { return VK_IMAGE_LAYOUT_GENERAL; }
+  VkExtent2D getExtent() const { return extent; }
+  uint32_t getMipCount() const { return mipCount; }
+
+ private:
+  struct PushConstants {
+    int32_t inputSize[2];
+    int32_t outputSize[2];
+  };
+
+  void createPipelineLayout();
+  void createSampler();
+  void createPyramid(VkExtent2D depthExtent);
+  void destroyPyramid();
+  void createDescriptorSets();
+  // level 0 reads this frame's depth attachment, rewritten when it changes
+  void updateDepthInput(int frameIndex, VkImageView depthView);
+
+  LveDevice &lveDevice;
+  uint32_t frameCount;
+
+  std::unique_ptr<LveDescriptorSetLayout> setLayout;
+  VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  std::unique_ptr<LveComputePipeline> reducePipeline;
+  VkSampler sampler = VK_NULL_HANDLE;
+
+  VkExtent2D depthExtent{0, 0};
+  VkExtent2D extent{0, 0};
+  uint32_t mipCount = 0;
+  VkImage image = VK_NULL_HANDLE;
+  LveAllocation imageMemory{};
+  VkImageView view = VK_NULL_HANDLE;
+  std::vector<VkImageView> levelViews;
+
+  // recreated with the pyramid, frames in flight keep their sets until the pool is destroyed
+  std::shared_ptr<LveDescriptorPool> descriptorPool;
+  // level i reads level i - 1, level 0 has a set per frame slot instead
+  std::vector<VkDescriptorSet> levelSets;
+  std::vector<VkDescriptorSet> depthSets;
+  std::vector<VkImageView> boundDepthViews;
+};
+
+}  // namespace lve
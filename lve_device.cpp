@@ -1,4 +1,5 @@
 #include "lve_device.hpp"
+#include "lve_staging_ring.hpp"
 
 // std headers
 #include <cstring>
@@ -78,7 +79,7 @@ namespace lve
     }
   }
   // class member functions
-  LveDevice::LveDevice(LveWindow &window) : window{window}
+  LveDevice::LveDevice(LveWindow &window) : window{&window}
   {
     //checkExtention();
     createInstance();      // -> vulkan instance
@@ -86,12 +87,28 @@ namespace lve
     createSurface();       // connection between vulkan and window
     pickPhysicalDevice();  // pick the best gpu (maybe?)
     createLogicalDevice(); // create logical device to interface with physical device
-    createCommandPool();   // comment buffer allocation
+    allocator_ = std::make_unique<LveAllocator>(physicalDevice, device_); // sub-allocates device memory
+    createTransientCommandPool(); // command buffers for uploads
+    stagingRing_ = std::make_unique<LveStagingRing>(*this); // uploads stream through this
+  }
+
+  LveDevice::LveDevice()
+  {
+    createInstance();
+    setupDebugMessenger();
+    pickPhysicalDevice();  // any device with a graphics queue, software rasterizers included
+    createLogicalDevice();
+    allocator_ = std::make_unique<LveAllocator>(physicalDevice, device_);
+    createTransientCommandPool();
+    stagingRing_ = std::make_unique<LveStagingRing>(*this);
   }
 
   LveDevice::~LveDevice()
   {
-    vkDestroyCommandPool(device_, commandPool, nullptr);
+    deletionQueue_.flushAll();
+    stagingRing_.reset();
+    allocator_.reset();
+    vkDestroyCommandPool(device_, transientCommandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
 
     if (enableValidationLayers)
@@ -99,7 +116,10 @@ namespace lve
       DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(instance, surface_, nullptr);
+    if (surface_ != VK_NULL_HANDLE)
+    {
+      vkDestroySurfaceKHR(instance, surface_, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
   }
 
@@ -120,12 +140,19 @@ namespace lve
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    createInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR; // for macos support
     createInfo.pApplicationInfo = &appInfo;
 
     auto extensions = getRequiredExtensions();
-    extensions.push_back("VK_KHR_portability_enumeration"); // for macos support
-    extensions.push_back("VK_KHR_get_physical_device_properties2"); 
+    // for macos support, other loaders (lavapipe, most linux drivers) do not expose these
+    if (hasInstanceExtension("VK_KHR_portability_enumeration"))
+    {
+      createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+      extensions.push_back("VK_KHR_portability_enumeration");
+    }
+    if (hasInstanceExtension("VK_KHR_get_physical_device_properties2"))
+    {
+      extensions.push_back("VK_KHR_get_physical_device_properties2");
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -200,8 +227,14 @@ namespace lve
       queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // indirect draws of the whole scene, see LveIndirectBuffer
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -210,8 +243,9 @@ namespace lve
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    auto extensions = getDeviceExtensions(physicalDevice);
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -229,28 +263,38 @@ namespace lve
     {
       throw std::runtime_error("failed to create logical device!");
     }
+    enabledFeatures = deviceFeatures;
+
+    for (const char *extension : extensions)
+    {
+      if (strcmp(extension, "VK_KHR_draw_indirect_count") == 0)
+      {
+        cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+      }
+    }
 
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
   }
 
-  void LveDevice::createCommandPool()
+  void LveDevice::createTransientCommandPool()
   {
     QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
     VkCommandPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-    poolInfo.flags =
-        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    // buffers from here are recorded once, submitted once and freed, never reset
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transientCommandPool) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to create command pool!");
     }
   }
 
-  void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+  void LveDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
   bool LveDevice::isDeviceSuitable(VkPhysicalDevice device)
   {
@@ -258,8 +302,9 @@ namespace lve
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported)
+    // headless devices never present
+    bool swapChainAdequate = isHeadless();
+    if (extensionsSupported && !isHeadless())
     {
       SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
       swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -330,11 +375,14 @@ namespace lve
 
   std::vector<const char *> LveDevice::getRequiredExtensions()
   {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions;
+    if (!isHeadless())
+    {
+      uint32_t glfwExtensionCount = 0;
+      const char **glfwExtensions;
+      glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+      extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers)
     {
@@ -383,7 +431,8 @@ namespace lve
         &extensionCount,
         availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    auto deviceExtensionList = getDeviceExtensions(device);
+    std::set<std::string> requiredExtensions(deviceExtensionList.begin(), deviceExtensionList.end());
 
     for (const auto &extension : availableExtensions)
     {
@@ -393,6 +442,52 @@ namespace lve
     return requiredExtensions.empty();
   }
 
+  std::vector<const char *> LveDevice::getDeviceExtensions(VkPhysicalDevice device)
+  {
+    std::vector<const char *> extensions;
+    if (!isHeadless())
+    {
+      extensions = deviceExtensions;
+    }
+
+    // the spec requires enabling it wherever it is exposed
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+    for (const auto &extension : availableExtensions)
+    {
+      if (strcmp(extension.extensionName, "VK_KHR_portability_subset") == 0)
+      {
+        extensions.push_back("VK_KHR_portability_subset");
+      }
+      for (const char *optional : optionalDeviceExtensions)
+      {
+        if (strcmp(extension.extensionName, optional) == 0)
+        {
+          extensions.push_back(optional);
+        }
+      }
+    }
+    return extensions;
+  }
+
+  bool LveDevice::hasInstanceExtension(const char *name)
+  {
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+    for (const auto &extension : extensions)
+    {
+      if (strcmp(extension.extensionName, name) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
   QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device)
   {
     QueueFamilyIndices indices;
@@ -411,8 +506,16 @@ namespace lve
         indices.graphicsFamily = i;
         indices.graphicsFamilyHasValue = true;
       }
+      // without a surface nothing is presented, the graphics queue stands in for the present queue
       VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (surface_ != VK_NULL_HANDLE)
+      {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      }
+      else
+      {
+        presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+      }
       if (queueFamily.queueCount > 0 && presentSupport)
       {
         indices.presentFamily = i;
@@ -500,7 +603,7 @@ namespace lve
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory)
+      LveAllocation &bufferMemory)
   {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -516,17 +619,12 @@ namespace lve
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    bufferMemory = allocator_->allocate(memRequirements, properties, LveAllocator::ResourceKind::Linear);
 
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    if (vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS)
     {
-      throw std::runtime_error("failed to allocate vertex buffer memory!");
+      throw std::runtime_error("failed to bind buffer memory!");
     }
-
-    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
   }
 
   VkCommandBuffer LveDevice::beginSingleTimeCommands()
@@ -534,7 +632,7 @@ namespace lve
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
+    allocInfo.commandPool = transientCommandPool;
     allocInfo.commandBufferCount = 1;
 
     VkCommandBuffer commandBuffer;
@@ -560,7 +658,7 @@ namespace lve
     vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
     vkQueueWaitIdle(graphicsQueue_);
 
-    vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+    vkFreeCommandBuffers(device_, transientCommandPool, 1, &commandBuffer);
   }
 
   void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -608,7 +706,7 @@ namespace lve
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory)
+      LveAllocation &imageMemory)
   {
     if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
     {
@@ -618,17 +716,14 @@ namespace lve
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate image memory!");
-    }
+    // linear images follow the same granularity rules as buffers
+    imageMemory = allocator_->allocate(
+        memRequirements,
+        properties,
+        imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? LveAllocator::ResourceKind::Linear
+                                                   : LveAllocator::ResourceKind::Optimal);
 
-    if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+    if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to bind image memory!");
     }
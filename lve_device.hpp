@@ -1,13 +1,18 @@
 #pragma once
 
+#include "lve_allocator.hpp"
+#include "lve_deletion_queue.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+class LveStagingRing;
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -31,6 +36,8 @@ class LveDevice {
 #endif
 
   LveDevice(LveWindow &window);
+  // headless: no surface, no swapchain extension and GLFW is never touched, for offscreen rendering
+  LveDevice();
   ~LveDevice();
 
   // Not copyable or movable
@@ -39,11 +46,19 @@ class LveDevice {
   LveDevice(LveDevice &&) = delete;
   LveDevice &operator=(LveDevice &&) = delete;
 
-  VkCommandPool getCommandPool() { return commandPool; }
+  // one-shot upload and copy commands only, frame commands come from LveCommandAllocator
+  VkCommandPool getTransientCommandPool() { return transientCommandPool; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
+  VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+  bool isHeadless() const { return window == nullptr; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  LveAllocator &allocator() { return *allocator_; }
+  // resources released while frames are in flight go here instead of being destroyed directly
+  LveDeletionQueue &deletionQueue() { return deletionQueue_; }
+  // persistent staging memory shared by every upload
+  LveStagingRing &stagingRing() { return *stagingRing_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -57,7 +72,7 @@ class LveDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation &bufferMemory);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -68,9 +83,14 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation &imageMemory);
 
   VkPhysicalDeviceProperties properties;
+  // what createLogicalDevice turned on, optional features are only set where supported
+  VkPhysicalDeviceFeatures enabledFeatures{};
+
+  // vkCmdDrawIndexedIndirectCount(KHR), null unless VK_KHR_draw_indirect_count is available
+  PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
 
  private:
   void checkExtention();
@@ -79,7 +99,7 @@ class LveDevice {
   void createSurface();
   void pickPhysicalDevice();
   void createLogicalDevice();
-  void createCommandPool();
+  void createTransientCommandPool();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -89,21 +109,29 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  std::vector<const char *> getDeviceExtensions(VkPhysicalDevice device);
+  bool hasInstanceExtension(const char *name);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LveWindow &window;
-  VkCommandPool commandPool;
+  LveWindow *window = nullptr;
+  VkCommandPool transientCommandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  std::unique_ptr<LveAllocator> allocator_;
+  LveDeletionQueue deletionQueue_;
+  std::unique_ptr<LveStagingRing> stagingRing_;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"};
+  // VK_KHR_portability_subset is added on devices that expose it (MoltenVK)
+  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  // enabled when present, nothing depends on them being there
+  const std::vector<const char *> optionalDeviceExtensions = {"VK_KHR_draw_indirect_count"};
 };
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "lve_ecs.hpp"
+
+// std
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace lve {
+
+namespace ecs_detail {
+
+namespace {
+
+std::mutex &registryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// a fixed array, references to registered types stay valid and lookups need no lock
+LveComponentType *registry() {
+  static LveComponentType types[MAX_COMPONENT_TYPES];
+  return types;
+}
+
+uint32_t registeredCount = 0;
+
+}  // namespace
+
+uint32_t registerComponentType(const LveComponentType &type) {
+  std::lock_guard<std::mutex> lock{registryMutex()};
+  if (registeredCount == MAX_COMPONENT_TYPES) {
+    throw std::runtime_error("too many component types");
+  }
+  registry()[registeredCount] = type;
+  return registeredCount++;
+}
+
+const LveComponentType &componentType(uint32_t id) {
+  assert(id < MAX_COMPONENT_TYPES && "Unknown component type");
+  return registry()[id];
+}
+
+}  // namespace ecs_detail
+
+namespace {
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+LveArchetype::LveArchetype(LveComponentMask mask) : mask{mask} {
+  std::fill(std::begin(columnIndex), std::end(columnIndex), int8_t{-1});
+  for (uint32_t id = 0; id < MAX_COMPONENT_TYPES; id++) {
+    if (mask & (LveComponentMask{1} << id)) {
+      columnIndex[id] = static_cast<int8_t>(typeIds.size());
+      typeIds.push_back(id);
+    }
+  }
+  columnOffsets.resize(typeIds.size());
+
+  // the entity array first, then one array per component, each starting on its own alignment
+  auto layout = [&](uint32_t capacity) {
+    size_t offset = capacity * sizeof(LveEntity);
+    for (size_t column = 0; column < typeIds.size(); column++) {
+      const LveComponentType &type = ecs_detail::componentType(typeIds[column]);
+      offset = alignUp(offset, type.alignment);
+      columnOffsets[column] = offset;
+      offset += capacity * type.size;
+    }
+    return offset;
+  };
+  size_t rowBytes = sizeof(LveEntity);
+  for (uint32_t id : typeIds) {
+    rowBytes += ecs_detail::componentType(id).size;
+  }
+  chunkCapacity = static_cast<uint32_t>(std::max<size_t>(CHUNK_BYTES / rowBytes, 1));
+  while (chunkCapacity > 1 && layout(chunkCapacity) > CHUNK_BYTES) {
+    chunkCapacity--;
+  }
+  // a component larger than a chunk gets a chunk of its own size
+  chunkBytes = alignUp(std::max(layout(chunkCapacity), CHUNK_BYTES), CHUNK_ALIGNMENT);
+}
+
+LveArchetype::~LveArchetype() {
+  for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+    for (uint32_t row = 0; row < chunks[chunk].count; row++) {
+      for (uint32_t id : typeIds) {
+        ecs_detail::componentType(id).destroy(component(chunk, row, id));
+      }
+    }
+  }
+}
+
+size_t LveArchetype::size() const {
+  // every chunk but the last one is full
+  return chunks.empty() ? 0 : (chunks.size() - 1) * chunkCapacity + chunks.back().count;
+}
+
+std::pair<uint32_t, uint32_t> LveArchetype::allocateRow(LveEntity entity) {
+  if (chunks.empty() || chunks.back().count == chunkCapacity) {
+    Chunk chunk{};
+    chunk.memory.reset(
+        static_cast<std::byte *>(::operator new(chunkBytes, std::align_val_t{CHUNK_ALIGNMENT})));
+    chunks.push_back(std::move(chunk));
+  }
+  const uint32_t chunk = static_cast<uint32_t>(chunks.size() - 1);
+  const uint32_t row = chunks[chunk].count++;
+  entities(chunk)[row] = entity;
+  return {chunk, row};
+}
+
+LveEntity LveArchetype::removeRow(uint32_t chunk, uint32_t row, bool destroyComponents) {
+  assert(chunk < chunks.size() && row < chunks[chunk].count && "Row out of range");
+  if (destroyComponents) {
+    for (uint32_t id : typeIds) {
+      ecs_detail::componentType(id).destroy(component(chunk, row, id));
+    }
+  }
+
+  const uint32_t lastChunk = static_cast<uint32_t>(chunks.size() - 1);
+  const uint32_t lastRow = chunks[lastChunk].count - 1;
+  LveEntity moved{};
+  if (chunk != lastChunk || row != lastRow) {
+    for (uint32_t id : typeIds) {
+      ecs_detail::componentType(id).relocate(
+          component(chunk, row, id), component(lastChunk, lastRow, id));
+    }
+    moved = entities(lastChunk)[lastRow];
+    entities(chunk)[row] = moved;
+  }
+  if (--chunks[lastChunk].count == 0) {
+    chunks.pop_back();
+  }
+  return moved;
+}
+
+void LveWorld::destroyEntity(LveEntity entity) {
+  Record *record = records.get(entity);
+  if (record == nullptr) return;
+  const uint32_t chunk = record->chunk, row = record->row;
+  LveEntity moved = record->archetype->removeRow(chunk, row, true);
+  fixMovedRow(moved, chunk, row);
+  records.erase(entity);
+}
+
+void LveWorld::clear() {
+  for (auto &archetype : archetypes) {
+    while (archetype->getChunkCount() > 0) {
+      const uint32_t lastChunk = static_cast<uint32_t>(archetype->getChunkCount() - 1);
+      archetype->removeRow(lastChunk, archetype->getCount(lastChunk) - 1, true);
+    }
+  }
+  records.clear();
+}
+
+LveArchetype &LveWorld::archetypeFor(LveComponentMask mask) {
+  auto found = archetypesByMask.find(mask);
+  if (found != archetypesByMask.end()) {
+    return *found->second;
+  }
+  archetypes.push_back(std::make_unique<LveArchetype>(mask));
+  LveArchetype *archetype = archetypes.back().get();
+  archetypesByMask.emplace(mask, archetype);
+  // queries seen before pick up the new archetype here instead of rescanning on every run
+  for (auto &[queryMask, matching] : queryCache) {
+    if ((mask & queryMask) == queryMask) {
+      matching.push_back(archetype);
+    }
+  }
+  return *archetype;
+}
+
+const std::vector<LveArchetype *> &LveWorld::matchingArchetypes(LveComponentMask mask) {
+  auto found = queryCache.find(mask);
+  if (found != queryCache.end()) {
+    return found->second;
+  }
+  std::vector<LveArchetype *> matching;
+  for (auto &archetype : archetypes) {
+    if ((archetype->getMask() & mask) == mask) {
+      matching.push_back(archetype.get());
+    }
+  }
+  return queryCache.emplace(mask, std::move(matching)).first->second;
+}
+
+LveWorld::Record &LveWorld::moveEntity(LveEntity entity, LveComponentMask mask) {
+  Record &record = *records.get(entity);
+  LveArchetype &from = *record.archetype;
+  LveArchetype &to = archetypeFor(mask);
+  const uint32_t fromChunk = record.chunk, fromRow = record.row;
+
+  auto [toChunk, toRow] = to.allocateRow(entity);
+  for (uint32_t id : from.getTypeIds()) {
+    void *source = from.component(fromChunk, fromRow, id);
+    if (to.has(id)) {
+      ecs_detail::componentType(id).relocate(to.component(toChunk, toRow, id), source);
+    } else {
+      ecs_detail::componentType(id).destroy(source);
+    }
+  }
+  LveEntity moved = from.removeRow(fromChunk, fromRow, false);
+  fixMovedRow(moved, fromChunk, fromRow);
+
+  record = {&to, toChunk, toRow};
+  return record;
+}
+
+void LveWorld::fixMovedRow(LveEntity moved, uint32_t chunk, uint32_t row) {
+  if (moved.index == LveSlotHandle::INVALID_INDEX) return;
+  Record *record = records.get(moved);
+  assert(record != nullptr && "Moved row has no live entity");
+  record->chunk = chunk;
+  record->row = row;
+}
+
+}  // namespace lve
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "lve_slot_map.hpp"
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+// entities are handles into the world's record table, stale after destroyEntity
+using LveEntity = LveSlotHandle;
+
+// a set of component types, one bit per type id
+using LveComponentMask = uint64_t;
+static constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+
+// what the archetypes need to know to store a component type without knowing the type
+struct LveComponentType {
+  size_t size;
+  size_t alignment;
+  // move constructs into destination and destroys source
+  void (*relocate)(void *destination, void *source);
+  void (*destroy)(void *value);
+};
+
+namespace ecs_detail {
+uint32_t registerComponentType(const LveComponentType &type);
+const LveComponentType &componentType(uint32_t id);
+}  // namespace ecs_detail
+
+// ids are handed out on first use, in no fixed order between runs
+template <typename T>
+uint32_t componentTypeId() {
+  static_assert(std::is_nothrow_move_constructible<T>::value, "Components are relocated by moving");
+  static const uint32_t id = ecs_detail::registerComponentType(
+      {sizeof(T),
+       alignof(T),
+       [](void *destination, void *source) {
+         new (destination) T(std::move(*static_cast<T *>(source)));
+         static_cast<T *>(source)->~T();
+       },
+       [](void *value) { static_cast<T *>(value)->~T(); }});
+  return id;
+}
+
+template <typename... Components>
+LveComponentMask componentMask() {
+  return (LveComponentMask{0} | ... | (LveComponentMask{1} << componentTypeId<Components>()));
+}
+
+/*
+ * Every entity with exactly one set of component types, in fixed size chunks.
+ *
+ * A chunk holds up to getChunkCapacity() entities with one array per component type (structure of
+ * arrays), so a query touches only the arrays of the components it asks for. Rows are kept dense:
+ * removing one moves the archetype's last row into the hole and drops the last chunk once empty.
+ */
+class LveArchetype {
+ public:
+  static constexpr size_t CHUNK_BYTES = 16 * 1024;
+  static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+  explicit LveArchetype(LveComponentMask mask);
+  ~LveArchetype();
+
+  LveArchetype(const LveArchetype &) = delete;
+  LveArchetype &operator=(const LveArchetype &) = delete;
+
+  LveComponentMask getMask() const { return mask; }
+  bool has(uint32_t typeId) const { return columnIndex[typeId] >= 0; }
+  uint32_t getChunkCapacity() const { return chunkCapacity; }
+  size_t getChunkCount() const { return chunks.size(); }
+  uint32_t getCount(size_t chunk) const { return chunks[chunk].count; }
+  size_t size() const;
+
+  LveEntity *entities(size_t chunk) {
+    return reinterpret_cast<LveEntity *>(chunks[chunk].memory.get());
+  }
+  void *column(size_t chunk, uint32_t typeId) {
+    assert(has(typeId) && "Component not in this archetype");
+    return chunks[chunk].memory.get() + columnOffsets[columnIndex[typeId]];
+  }
+  template <typename T>
+  T *column(size_t chunk) {
+    return static_cast<T *>(column(chunk, componentTypeId<T>()));
+  }
+  void *component(size_t chunk, uint32_t row, uint32_t typeId) {
+    return static_cast<std::byte *>(column(chunk, typeId)) +
+           row * ecs_detail::componentType(typeId).size;
+  }
+  const std::vector<uint32_t> &getTypeIds() const { return typeIds; }
+
+  // appends a row for entity, its components are left for the caller to construct
+  std::pair<uint32_t, uint32_t> allocateRow(LveEntity entity);
+  // destroys the row's components unless they were relocated already, fills the hole with the last
+  // row and returns the entity of that row (or an invalid handle when the hole was the last row)
+  LveEntity removeRow(uint32_t chunk, uint32_t row, bool destroyComponents);
+
+ private:
+  struct ChunkDeleter {
+    void operator()(std::byte *memory) const {
+      ::operator delete(memory, std::align_val_t{CHUNK_ALIGNMENT});
+    }
+  };
+  struct Chunk {
+    std::unique_ptr<std::byte, ChunkDeleter> memory;
+    uint32_t count = 0;
+  };
+
+  LveComponentMask mask;
+  std::vector<uint32_t> typeIds;
+  // per column of typeIds, the byte offset of its array in a chunk
+  std::vector<size_t> columnOffsets;
+  int8_t columnIndex[MAX_COMPONENT_TYPES];
+  uint32_t chunkCapacity = 0;
+  size_t chunkBytes = 0;
+  std::vector<Chunk> chunks;
+};
+
+/*
+ * Entities and their components, grouped into archetypes by the set of component types they have.
+ *
+ * Queries (each, eachChunk) visit only the archetypes holding every requested type; the matching
+ * archetypes of a query are cached, so a query nothing matches costs a hash lookup. Adding or
+ * removing a component moves the entity to another archetype. Structural changes (create, destroy,
+ * add, remove) invalidate component pointers and must not happen while a query runs.
+ */
+class LveWorld {
+ public:
+  LveWorld() = default;
+  ~LveWorld() { clear(); }
+
+  LveWorld(const LveWorld &) = delete;
+  LveWorld &operator=(const LveWorld &) = delete;
+
+  template <typename... Components>
+  LveEntity createEntity(Components &&...components) {
+    LveArchetype &archetype = archetypeFor(componentMask<std::decay_t<Components>...>());
+    assert(
+        archetype.getTypeIds().size() == sizeof...(Components) &&
+        "An entity has at most one component of each type");
+    LveEntity entity = records.insert({&archetype, 0, 0});
+    auto [chunk, row] = archetype.allocateRow(entity);
+    (new (archetype.column<std::decay_t<Components>>(chunk) + row)
+         std::decay_t<Components>(std::forward<Components>(components)),
+     ...);
+    *records.get(entity) = {&archetype, chunk, row};
+    return entity;
+  }
+  void destroyEntity(LveEntity entity);
+  bool isAlive(LveEntity entity) const { return records.contains(entity); }
+
+  // nullptr when the entity is gone or lacks the component
+  template <typename T>
+  T *getComponent(LveEntity entity) {
+    Record *record = records.get(entity);
+    if (record == nullptr || !record->archetype->has(componentTypeId<T>())) return nullptr;
+    return record->archetype->column<T>(record->chunk) + record->row;
+  }
+  template <typename T>
+  bool hasComponent(LveEntity entity) {
+    return getComponent<T>(entity) != nullptr;
+  }
+  // replaces the component when the entity has it already, nullptr (and nothing added) when the
+  // entity is gone
+  template <typename T>
+  std::decay_t<T> *addComponent(LveEntity entity, T &&value) {
+    using Component = std::decay_t<T>;
+    Record *current = records.get(entity);
+    if (current == nullptr) return nullptr;
+    if (Component *existing = getComponent<Component>(entity)) {
+      *existing = std::forward<T>(value);
+      return existing;
+    }
+    Record &record = moveEntity(entity, current->archetype->getMask() | componentMask<Component>());
+    return new (record.archetype->column<Component>(record.chunk) + record.row)
+        Component(std::forward<T>(value));
+  }
+  // does nothing when the entity is gone or lacks the component
+  template <typename T>
+  void removeComponent(LveEntity entity) {
+    Record *current = records.get(entity);
+    if (current == nullptr || !current->archetype->has(componentTypeId<T>())) return;
+    moveEntity(entity, current->archetype->getMask() & ~componentMask<T>());
+  }
+
+  // fn(uint32_t count, const LveEntity *entities, Components *...arrays) once per chunk of every
+  // archetype with at least Components
+  template <typename... Components, typename Fn>
+  void eachChunk(Fn &&fn) {
+    for (LveArchetype *archetype : matchingArchetypes(componentMask<Components...>())) {
+      for (size_t chunk = 0; chunk < archetype->getChunkCount(); chunk++) {
+        fn(archetype->getCount(chunk),
+           static_cast<const LveEntity *>(archetype->entities(chunk)),
+           archetype->column<Components>(chunk)...);
+      }
+    }
+  }
+  // fn(LveEntity entity, Components &...components) for every entity with at least Components
+  template <typename... Components, typename Fn>
+  void each(Fn &&fn) {
+    eachChunk<Components...>([&](uint32_t count, const LveEntity *entities, Components *...arrays) {
+      for (uint32_t i = 0; i < count; i++) {
+        fn(entities[i], arrays[i]...);
+      }
+    });
+  }
+  // how many entities have at least Components
+  template <typename... Components>
+  size_t count() {
+    size_t total = 0;
+    for (LveArchetype *archetype : matchingArchetypes(componentMask<Components...>())) {
+      total += archetype->size();
+    }
+    return total;
+  }
+
+  size_t size() const { return records.size(); }
+  size_t getArchetypeCount() const { return archetypes.size(); }
+  // destroys every entity, the archetypes stay for the next entities
+  void clear();
+
+ private:
+  struct Record {
+    LveArchetype *archetype;
+    uint32_t chunk;
+    uint32_t row;
+  };
+
+  LveArchetype &archetypeFor(LveComponentMask mask);
+  const std::vector<LveArchetype *> &matchingArchetypes(LveComponentMask mask);
+  // relocates the components both archetypes have, destroys the rest. Components the new
+  // archetype adds are left for the caller to construct
+  Record &moveEntity(LveEntity entity, LveComponentMask mask);
+  // points the record of an entity moved by removeRow at its new row
+  void fixMovedRow(LveEntity moved, uint32_t chunk, uint32_t row);
+
+  LveSlotMap<Record> records;
+  std::vector<std::unique_ptr<LveArchetype>> archetypes;
+  std::unordered_map<LveComponentMask, LveArchetype *> archetypesByMask;
+  std::unordered_map<LveComponentMask, std::vector<LveArchetype *>> queryCache;
+};
+
+}  // namespace lve
@@ -2,17 +2,45 @@
 
 #include "lve_camera.hpp"
 #include "lve_game_object.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_indirect_buffer.hpp"
+#include "lve_object_buffer.hpp"
+#include "lve_secondary_recorder.hpp"
 
 //lib
 #include<vulkan/vulkan.h>
 
 namespace lve {
+    // must match MAX_LIGHTS in the shaders
+    static constexpr int MAX_LIGHTS = 64;
+
+    struct PointLight {
+        glm::vec4 position{}; // ignore w
+        glm::vec4 color{}; // w is intensity
+    };
+
+    // mirrors GlobalUbo in the shaders (std140)
+    struct GlobalUbo {
+        glm::mat4 projection{1.f};
+        glm::mat4 view{1.f};
+        glm::vec4 ambientLightColor{1.f, 1.f, 1.f, .02f}; // w is intensity
+        PointLight pointLights[MAX_LIGHTS];
+        int numLights = 0;
+    };
+
     struct FrameInfo {
         int frameIndex;
         float frameTime;
         VkCommandBuffer commandBuffer;
         LveCamera &camera;
         VkDescriptorSet globalDescriptorSet;
-        LveGameObject::Map &gameObjects;
+        LveWorld &world;
+        LveObjectBuffer &objectBuffer;
+        LveGpuProfiler &gpuProfiler;
+        // set when the render pass takes secondary command buffers, systems then record through it
+        // instead of into commandBuffer
+        LveSecondaryRecorder *secondaryRecorder = nullptr;
+        // set when the scene is drawn with indirect commands, see SimpleRenderSystem
+        LveIndirectBuffer *indirectBuffer = nullptr;
     };
 }
\ No newline at end of file
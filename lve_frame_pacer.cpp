@@ -0,0 +1,62 @@
+#include "lve_frame_pacer.hpp"
+
+// std
+#include <thread>
+
+namespace lve {
+
+void LveFramePacer::setFrameLimit(float fps) {
+  auto newPeriod = fps > 0.f ? std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(1.0 / fps))
+                             : Clock::duration{0};
+  if (newPeriod != period) {
+    period = newPeriod;
+    deadline = Clock::now();
+  }
+}
+
+void LveFramePacer::waitForNextFrame() {
+  if (period == Clock::duration{0}) {
+    return;
+  }
+
+  auto now = Clock::now();
+  deadline += period;
+  if (deadline < now) {
+    // more than a frame behind, don't try to catch up with a burst of frames
+    deadline = now;
+    return;
+  }
+
+  if (deadline - now > SPIN_MARGIN) {
+    std::this_thread::sleep_for(deadline - now - SPIN_MARGIN);
+  }
+  while (Clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+void LveFramePacer::markInputSampled(int frameIndex, Clock::time_point sampledAt) {
+  inputTimes[frameIndex] = sampledAt;
+}
+
+void LveFramePacer::markFrameCompleted(int frameIndex) {
+  if (inputTimes[frameIndex] == Clock::time_point{}) {
+    return;
+  }
+  float latencyMs =
+      std::chrono::duration<float, std::milli>(Clock::now() - inputTimes[frameIndex]).count();
+  inputTimes[frameIndex] = Clock::time_point{};
+
+  lastLatencyMs = latencyMs;
+  if (sampleCount == LATENCY_WINDOW) {
+    latencySum -= latencySamples[nextSample];
+  } else {
+    sampleCount++;
+  }
+  latencySamples[nextSample] = latencyMs;
+  latencySum += latencyMs;
+  nextSample = (nextSample + 1) % LATENCY_WINDOW;
+}
+
+}  // namespace lve
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "lve_swap_chain.hpp"
+
+// std
+#include <array>
+#include <chrono>
+
+namespace lve {
+
+/*
+ * Frame limiter and input-to-photon latency estimate.
+ *
+ * The limiter sleeps until shortly before the next frame deadline and spins the rest, since
+ * sleep_for alone overshoots by up to a scheduler tick. Latency is measured from the moment a
+ * frame sampled its input until the CPU observes that frame's fence, so it includes queueing and
+ * GPU time but not scan-out; with the CPU waiting on the fence this is a tight upper bound of
+ * when the image became presentable.
+ */
+class LveFramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // frames per second, 0 disables the limiter
+  void setFrameLimit(float fps);
+  void waitForNextFrame();
+
+  // sampledAt is when the input was read. Call after markFrameCompleted for the slot, the slot's
+  // previous frame is still measured from its own input time until then
+  void markInputSampled(int frameIndex, Clock::time_point sampledAt);
+  // call right after the fence of frameIndex's slot has been waited on
+  void markFrameCompleted(int frameIndex);
+
+  float getAverageLatencyMs() const { return sampleCount ? latencySum / sampleCount : 0.f; }
+  float getLastLatencyMs() const { return lastLatencyMs; }
+
+ private:
+  static constexpr auto SPIN_MARGIN = std::chrono::microseconds(1500);
+  static constexpr size_t LATENCY_WINDOW = 120;
+
+  Clock::duration period{0};
+  Clock::time_point deadline{};
+
+  std::array<Clock::time_point, LveSwapChain::MAX_FRAMES_IN_FLIGHT> inputTimes{};
+  std::array<float, LATENCY_WINDOW> latencySamples{};
+  size_t sampleCount = 0;
+  size_t nextSample = 0;
+  float latencySum = 0.f;
+  float lastLatencyMs = 0.f;
+};
+
+}  // namespace lve
@@ -0,0 +1,149 @@
+#include "lve_frame_stats.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace lve {
+
+LveFrameStats::LveFrameStats(size_t windowSize, float logInterval)
+    : windowSize{std::max<size_t>(windowSize, 1)}, logInterval{logInterval} {
+  samples.reserve(this->windowSize);
+}
+
+bool LveFrameStats::openCsv(const std::string &filePath) {
+  csv.open(filePath);
+  if (!csv) {
+    return false;
+  }
+  csv << "frame,cpu_frame_ms,gpu_ms,fence_wait_ms,acquire_wait_ms,present_wait_ms,hitch\n";
+  return true;
+}
+
+float LveFrameStats::value(const Sample &sample, Metric metric) {
+  switch (metric) {
+    case Metric::CpuFrame:
+      return sample.cpuFrameMs;
+    case Metric::Gpu:
+      return sample.gpuMs;
+    case Metric::FenceWait:
+      return sample.fenceWaitMs;
+    case Metric::AcquireWait:
+      return sample.acquireWaitMs;
+    case Metric::PresentWait:
+      return sample.presentWaitMs;
+    default:
+      return 0.f;
+  }
+}
+
+void LveFrameStats::record(const Sample &sample) {
+  if (samples.size() < windowSize) {
+    samples.push_back(sample);
+  } else {
+    samples[next] = sample;
+  }
+  next = (next + 1) % windowSize;
+  frameCount++;
+
+  // until the first summary the median is bootstrapped from the first frames
+  if (medianCpuFrameMs == 0.f && samples.size() >= 16) {
+    medianCpuFrameMs = summarize(Metric::CpuFrame).p50Ms;
+  }
+  lastHitch = medianCpuFrameMs > 0.f && sample.cpuFrameMs > HITCH_MIN_MS &&
+              sample.cpuFrameMs > HITCH_FACTOR * medianCpuFrameMs;
+  if (lastHitch) {
+    hitchCount++;
+    hitchesSinceLog++;
+  }
+
+  if (csv.is_open()) {
+    char row[128];
+    snprintf(
+        row,
+        sizeof(row),
+        "%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+        static_cast<unsigned long long>(frameCount),
+        sample.cpuFrameMs,
+        sample.gpuMs,
+        sample.fenceWaitMs,
+        sample.acquireWaitMs,
+        sample.presentWaitMs,
+        lastHitch ? 1 : 0);
+    csv << row;
+  }
+
+  secondsSinceLog += sample.cpuFrameMs / 1000.f;
+  if (logInterval > 0.f && secondsSinceLog >= logInterval) {
+    medianCpuFrameMs = summarize(Metric::CpuFrame).p50Ms;
+    std::cout << summaryLine() << std::endl;
+    secondsSinceLog = 0.f;
+    hitchesSinceLog = 0;
+  }
+}
+
+LveFrameStats::Summary LveFrameStats::summarize(Metric metric) const {
+  Summary summary{};
+  if (samples.empty()) {
+    return summary;
+  }
+
+  std::vector<float> sorted;
+  sorted.reserve(samples.size());
+  for (auto &sample : samples) {
+    sorted.push_back(value(sample, metric));
+  }
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&](float p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+  };
+
+  float sum = 0.f;
+  for (float ms : sorted) {
+    sum += ms;
+  }
+  summary.averageMs = sum / sorted.size();
+  summary.p50Ms = percentile(0.50f);
+  summary.p95Ms = percentile(0.95f);
+  summary.p99Ms = percentile(0.99f);
+  summary.maxMs = sorted.back();
+
+  size_t slowCount = std::max<size_t>(sorted.size() / 100, 1);
+  float slowSum = 0.f;
+  for (size_t i = sorted.size() - slowCount; i < sorted.size(); i++) {
+    slowSum += sorted[i];
+  }
+  summary.onePercentLowFps = slowSum > 0.f ? 1000.f * slowCount / slowSum : 0.f;
+  return summary;
+}
+
+std::string LveFrameStats::summaryLine() const {
+  Summary cpu = summarize(Metric::CpuFrame);
+  Summary gpu = summarize(Metric::Gpu);
+  Summary fence = summarize(Metric::FenceWait);
+  Summary acquire = summarize(Metric::AcquireWait);
+  Summary present = summarize(Metric::PresentWait);
+
+  char line[320];
+  snprintf(
+      line,
+      sizeof(line),
+      "frame %.2f/%.2f/%.2f/%.2f ms (p50/p95/p99/max), 1%% low %.1f fps | gpu p50 %.2f p99 %.2f ms"
+      " | fence p99 %.2f ms | acquire p99 %.2f ms | present p99 %.2f ms | hitches %llu (%llu total)",
+      cpu.p50Ms,
+      cpu.p95Ms,
+      cpu.p99Ms,
+      cpu.maxMs,
+      cpu.onePercentLowFps,
+      gpu.p50Ms,
+      gpu.p99Ms,
+      fence.p99Ms,
+      acquire.p99Ms,
+      present.p99Ms,
+      static_cast<unsigned long long>(hitchesSinceLog),
+      static_cast<unsigned long long>(hitchCount));
+  return line;
+}
+
+}  // namespace lve
@@ -0,0 +1,83 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Frame time statistics over a sliding window.
+ *
+ * Each frame records its CPU frame time (loop to loop, unclamped), GPU time and the time the CPU
+ * blocked on the frame's in-flight fence, in image acquire and in submit/present. Percentiles are computed from the window on
+ * demand. A frame is flagged as a hitch when its CPU time exceeds HITCH_FACTOR times the window's
+ * median. Optionally every frame is appended to a CSV file, and a summary line is logged every
+ * logInterval seconds.
+ */
+class LveFrameStats {
+ public:
+  static constexpr size_t DEFAULT_WINDOW = 1000;
+  static constexpr float HITCH_FACTOR = 2.f;
+  // frames shorter than this never count as hitches, whatever the median
+  static constexpr float HITCH_MIN_MS = 4.f;
+
+  enum class Metric { CpuFrame, Gpu, FenceWait, AcquireWait, PresentWait, Count };
+
+  struct Sample {
+    float cpuFrameMs = 0.f;
+    float gpuMs = 0.f;
+    float fenceWaitMs = 0.f;
+    float acquireWaitMs = 0.f;
+    float presentWaitMs = 0.f;
+  };
+
+  struct Summary {
+    float averageMs = 0.f;
+    float p50Ms = 0.f;
+    float p95Ms = 0.f;
+    float p99Ms = 0.f;
+    float maxMs = 0.f;
+    // average fps of the slowest 1% of frames
+    float onePercentLowFps = 0.f;
+  };
+
+  explicit LveFrameStats(size_t windowSize = DEFAULT_WINDOW, float logInterval = 5.f);
+
+  LveFrameStats(const LveFrameStats &) = delete;
+  LveFrameStats &operator=(const LveFrameStats &) = delete;
+
+  // returns false when the file could not be opened
+  bool openCsv(const std::string &filePath);
+  // logs a summary line to stdout when the log interval has passed
+  void record(const Sample &sample);
+
+  Summary summarize(Metric metric) const;
+  std::string summaryLine() const;
+  bool lastFrameWasHitch() const { return lastHitch; }
+  uint64_t getFrameCount() const { return frameCount; }
+  uint64_t getHitchCount() const { return hitchCount; }
+
+ private:
+  static float value(const Sample &sample, Metric metric);
+
+  size_t windowSize;
+  float logInterval;
+  std::vector<Sample> samples;
+  size_t next = 0;
+
+  uint64_t frameCount = 0;
+  uint64_t hitchCount = 0;
+  uint64_t hitchesSinceLog = 0;
+  bool lastHitch = false;
+  float secondsSinceLog = 0.f;
+  // the median is refreshed once per log interval, sorting on every frame would cost more than
+  // the rest of this class
+  float medianCpuFrameMs = 0.f;
+
+  std::ofstream csv;
+};
+
+}  // namespace lve
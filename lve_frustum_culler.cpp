@@ -0,0 +1,255 @@
+#include "lve_frustum_culler.hpp"
+
+// std
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace lve {
+
+LveFrustum LveFrustum::fromViewProjection(const glm::mat4 &m) {
+  // glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+  auto row = [&](int i) { return glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]}; };
+  glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+  LveFrustum frustum{};
+  frustum.planes[0] = w + x;  // left
+  frustum.planes[1] = w - x;  // right
+  frustum.planes[2] = w + y;  // top (y points down)
+  frustum.planes[3] = w - y;  // bottom
+  frustum.planes[4] = z;      // near, depth starts at 0
+  frustum.planes[5] = w - z;  // far
+  for (auto &plane : frustum.planes) {
+    plane = plane / glm::length(glm::vec3{plane.x, plane.y, plane.z});
+  }
+  return frustum;
+}
+
+void LveBoundsTable::clear() {
+  count = 0;
+  for (auto *component : {&centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ}) {
+    component->clear();
+  }
+}
+
+void LveBoundsTable::reserve(uint32_t capacity) {
+  capacity = (capacity + LANES - 1) / LANES * LANES;
+  for (auto *component : {&centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ}) {
+    component->reserve(capacity);
+  }
+}
+
+uint32_t LveBoundsTable::add(const glm::vec3 &center, float r, const glm::vec3 &halfExtent) {
+  if (count == paddedSize()) {
+    // a negative size is outside of every plane
+    for (auto *component : {&centerX, &centerY, &centerZ}) {
+      component->resize(count + LANES, 0.f);
+    }
+    for (auto *component : {&radius, &extentX, &extentY, &extentZ}) {
+      component->resize(count + LANES, -FLT_MAX);
+    }
+  }
+  set(count, center, r, halfExtent);
+  return count++;
+}
+
+void LveBoundsTable::set(
+    uint32_t index, const glm::vec3 &center, float r, const glm::vec3 &halfExtent) {
+  assert(index < paddedSize() && "Bounds index out of range");
+  centerX[index] = center.x;
+  centerY[index] = center.y;
+  centerZ[index] = center.z;
+  radius[index] = r;
+  extentX[index] = halfExtent.x;
+  extentY[index] = halfExtent.y;
+  extentZ[index] = halfExtent.z;
+}
+
+namespace {
+
+// a box reaches as far along a plane's normal as its extents projected onto |normal|
+template <bool Boxes>
+uint32_t cullScalar(const LveFrustum &frustum, const LveBoundsTable &bounds, uint32_t *visible) {
+  uint32_t visibleCount = 0;
+  for (uint32_t i = 0; i < bounds.size(); i++) {
+    bool inside = true;
+    for (const auto &plane : frustum.planes) {
+      float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] +
+                       plane.z * bounds.centerZ[i] + plane.w;
+      float reach = Boxes ? std::abs(plane.x) * bounds.extentX[i] +
+                                std::abs(plane.y) * bounds.extentY[i] +
+                                std::abs(plane.z) * bounds.extentZ[i]
+                          : bounds.radius[i];
+      inside = inside && distance + reach > 0.f;
+    }
+    visible[visibleCount] = i;
+    visibleCount += inside ? 1 : 0;
+  }
+  return visibleCount;
+}
+
+#ifdef LVE_SIMD_X86
+
+template <bool Boxes>
+uint32_t cullSse(const LveFrustum &frustum, const LveBoundsTable &bounds, uint32_t *visible) {
+  __m128 planeX[LveFrustum::PLANE_COUNT], planeY[LveFrustum::PLANE_COUNT],
+      planeZ[LveFrustum::PLANE_COUNT], planeW[LveFrustum::PLANE_COUNT];
+  __m128 absX[LveFrustum::PLANE_COUNT], absY[LveFrustum::PLANE_COUNT],
+      absZ[LveFrustum::PLANE_COUNT];
+  for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+    const auto &plane = frustum.planes[p];
+    planeX[p] = _mm_set1_ps(plane.x);
+    planeY[p] = _mm_set1_ps(plane.y);
+    planeZ[p] = _mm_set1_ps(plane.z);
+    planeW[p] = _mm_set1_ps(plane.w);
+    absX[p] = _mm_set1_ps(std::abs(plane.x));
+    absY[p] = _mm_set1_ps(std::abs(plane.y));
+    absZ[p] = _mm_set1_ps(std::abs(plane.z));
+  }
+  const __m128 zero = _mm_setzero_ps();
+
+  uint32_t visibleCount = 0;
+  const uint32_t end = bounds.paddedSize();
+  for (uint32_t i = 0; i < end; i += 4) {
+    __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+    __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+    __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+    __m128 ex = zero, ey = zero, ez = zero, radius = zero;
+    if (Boxes) {
+      ex = _mm_loadu_ps(&bounds.extentX[i]);
+      ey = _mm_loadu_ps(&bounds.extentY[i]);
+      ez = _mm_loadu_ps(&bounds.extentZ[i]);
+    } else {
+      radius = _mm_loadu_ps(&bounds.radius[i]);
+    }
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+          _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+      __m128 reach = Boxes ? _mm_add_ps(
+                                 _mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+                                 _mm_mul_ps(absZ[p], ez))
+                           : radius;
+      inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(distance, reach), zero));
+    }
+    // branch free compaction, the padding guarantees room for the lanes written past the count
+    int mask = _mm_movemask_ps(inside);
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      visible[visibleCount] = i + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+  return visibleCount;
+}
+
+template <bool Boxes>
+LVE_TARGET_AVX2 uint32_t
+cullAvx2(const LveFrustum &frustum, const LveBoundsTable &bounds, uint32_t *visible) {
+  __m256 planeX[LveFrustum::PLANE_COUNT], planeY[LveFrustum::PLANE_COUNT],
+      planeZ[LveFrustum::PLANE_COUNT], planeW[LveFrustum::PLANE_COUNT];
+  __m256 absX[LveFrustum::PLANE_COUNT], absY[LveFrustum::PLANE_COUNT],
+      absZ[LveFrustum::PLANE_COUNT];
+  for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+    const auto &plane = frustum.planes[p];
+    planeX[p] = _mm256_set1_ps(plane.x);
+    planeY[p] = _mm256_set1_ps(plane.y);
+    planeZ[p] = _mm256_set1_ps(plane.z);
+    planeW[p] = _mm256_set1_ps(plane.w);
+    absX[p] = _mm256_set1_ps(std::abs(plane.x));
+    absY[p] = _mm256_set1_ps(std::abs(plane.y));
+    absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+  }
+  const __m256 zero = _mm256_setzero_ps();
+
+  uint32_t visibleCount = 0;
+  const uint32_t end = bounds.paddedSize();
+  for (uint32_t i = 0; i < end; i += LveBoundsTable::LANES) {
+    __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+    __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+    __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+    __m256 ex = zero, ey = zero, ez = zero, radius = zero;
+    if (Boxes) {
+      ex = _mm256_loadu_ps(&bounds.extentX[i]);
+      ey = _mm256_loadu_ps(&bounds.extentY[i]);
+      ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+    } else {
+      radius = _mm256_loadu_ps(&bounds.radius[i]);
+    }
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+      __m256 distance = _mm256_fmadd_ps(
+          planeX[p],
+          cx,
+          _mm256_fmadd_ps(planeY[p], cy, _mm256_fmadd_ps(planeZ[p], cz, planeW[p])));
+      __m256 reach =
+          Boxes ? _mm256_fmadd_ps(
+                      absX[p],
+                      ex,
+                      _mm256_fmadd_ps(absY[p], ey, _mm256_mul_ps(absZ[p], ez)))
+                : radius;
+      inside = _mm256_and_ps(
+          inside,
+          _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GT_OQ));
+    }
+    int mask = _mm256_movemask_ps(inside);
+    for (uint32_t lane = 0; lane < LveBoundsTable::LANES; lane++) {
+      visible[visibleCount] = i + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+  return visibleCount;
+}
+
+#endif  // LVE_SIMD_X86
+
+template <bool Boxes>
+uint32_t cull(
+    const LveFrustum &frustum,
+    const LveBoundsTable &bounds,
+    std::vector<uint32_t> &visible,
+    LveFrustumCuller::Path path) {
+  assert(LveFrustumCuller::isSupported(path) && "Culling path not supported on this CPU");
+  if (visible.size() < bounds.paddedSize()) {
+    visible.resize(bounds.paddedSize());
+  }
+  if (bounds.size() == 0) {
+    return 0;
+  }
+  uint32_t visibleCount = 0;
+  switch (path) {
+#ifdef LVE_SIMD_X86
+    case LveFrustumCuller::Path::Avx2:
+      visibleCount = cullAvx2<Boxes>(frustum, bounds, visible.data());
+      break;
+    case LveFrustumCuller::Path::Sse:
+      visibleCount = cullSse<Boxes>(frustum, bounds, visible.data());
+      break;
+#endif
+    default:
+      visibleCount = cullScalar<Boxes>(frustum, bounds, visible.data());
+      break;
+  }
+  // the padding never passes a plane test
+  assert(visibleCount <= bounds.size());
+  return visibleCount;
+}
+
+}  // namespace
+
+uint32_t LveFrustumCuller::cullSpheres(
+    const LveFrustum &frustum,
+    const LveBoundsTable &bounds,
+    std::vector<uint32_t> &visible,
+    Path path) {
+  return cull<false>(frustum, bounds, visible, path);
+}
+
+uint32_t LveFrustumCuller::cullBoxes(
+    const LveFrustum &frustum,
+    const LveBoundsTable &bounds,
+    std::vector<uint32_t> &visible,
+    Path path) {
+  return cull<true>(frustum, bounds, visible, path);
+}
+
+}  // namespace lve
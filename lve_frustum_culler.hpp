@@ -0,0 +1,87 @@
+#pragma once
+
+#include "lve_simd.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// the six planes of a view frustum in world space, normals pointing inwards and normalized
+struct LveFrustum {
+  static constexpr int PLANE_COUNT = 6;
+
+  // left, right, top, bottom, near, far
+  glm::vec4 planes[PLANE_COUNT];
+
+  // Gribb/Hartmann extraction for a [0, 1] depth range, pass projection * view
+  static LveFrustum fromViewProjection(const glm::mat4 &viewProjection);
+};
+
+/*
+ * World-space bounds of many objects in structure-of-arrays form, one float array per component.
+ *
+ * Every object has a bounding sphere and an axis aligned box sharing its center. The arrays are
+ * always padded to a multiple of LANES with bounds that fail every plane test, so the culling
+ * loops run whole batches and need no tail handling.
+ */
+class LveBoundsTable {
+ public:
+  static constexpr uint32_t LANES = 8;
+
+  void clear();
+  void reserve(uint32_t count);
+  // returns the object's index, the one the culler writes into the visible list
+  uint32_t add(const glm::vec3 &center, float radius, const glm::vec3 &halfExtent);
+  uint32_t addSphere(const glm::vec3 &center, float radius) {
+    return add(center, radius, glm::vec3{radius});
+  }
+  void set(uint32_t index, const glm::vec3 &center, float radius, const glm::vec3 &halfExtent);
+
+  uint32_t size() const { return count; }
+  // size() rounded up to LANES
+  uint32_t paddedSize() const { return static_cast<uint32_t>(radius.size()); }
+
+  std::vector<float> centerX, centerY, centerZ, radius;
+  std::vector<float> extentX, extentY, extentZ;
+
+ private:
+  uint32_t count = 0;
+};
+
+/*
+ * Frustum culling of an LveBoundsTable, LveBoundsTable::LANES objects per iteration.
+ *
+ * The AVX2 path is compiled in on x86 regardless of the build flags and picked at runtime when the
+ * CPU has AVX2 and FMA, the SSE path covers every other x86-64 CPU and the scalar path everything
+ * else. The paths agree up to rounding (the AVX2 one uses FMA) for bounds that just touch a plane.
+ */
+class LveFrustumCuller {
+ public:
+  using Path = LveSimdPath;
+
+  // the fastest path this CPU runs
+  static Path bestPath() { return bestSimdPath(); }
+  static bool isSupported(Path path) { return isSimdPathSupported(path); }
+  static const char *pathName(Path path) { return simdPathName(path); }
+
+  // writes the indices of the visible objects to visible in increasing order, returns their count.
+  // visible is grown to bounds.paddedSize() first, elements past the count are unspecified
+  static uint32_t cullSpheres(
+      const LveFrustum &frustum,
+      const LveBoundsTable &bounds,
+      std::vector<uint32_t> &visible,
+      Path path = bestPath());
+  static uint32_t cullBoxes(
+      const LveFrustum &frustum,
+      const LveBoundsTable &bounds,
+      std::vector<uint32_t> &visible,
+      Path path = bestPath());
+};
+
+}  // namespace lve
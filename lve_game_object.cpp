@@ -1,59 +1,66 @@
 #include "lve_game_object.hpp"
 
 namespace lve{
-    glm::mat4 TransformComponent::mat4() {
-        const float c3 = glm::cos(rotation.z);
-        const float s3 = glm::sin(rotation.z);
-        const float c2 = glm::cos(rotation.x);
-        const float s2 = glm::sin(rotation.x);
-        const float c1 = glm::cos(rotation.y);
-        const float s1 = glm::sin(rotation.y);
-        return glm::mat4{
-            {
-                scale.x * (c1 * c3 + s1 * s2 * s3),
-                scale.x * (c2 * s3),
-                scale.x * (c1 * s2 * s3 - c3 * s1),
-                0.0f,
-            },
-            {
-                scale.y * (c3 * s1 * s2 - c1 * s3),
-                scale.y * (c2 * c3),
-                scale.y * (c1 * c3 * s2 + s1 * s3),
-                0.0f,
-            },
-            {
-                scale.z * (c2 * s1),
-                scale.z * (-s2),
-                scale.z * (c1 * c2),
-                0.0f,
-            },
-            {translation.x, translation.y, translation.z, 1.0f}};
+    const glm::mat4 &TransformComponent::mat4() {
+        if (dirty) update();
+        return worldMatrix;
     }
-    glm::mat3 TransformComponent::normalMatrix(){
+    const glm::mat3 &TransformComponent::normalMatrix() {
+        if (dirty) update();
+        return normal;
+    }
+    void TransformComponent::update() {
+        // one sin/cos evaluation for both matrices, they share the rotation part
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
         const float c2 = glm::cos(rotation.x);
         const float s2 = glm::sin(rotation.x);
         const float c1 = glm::cos(rotation.y);
         const float s1 = glm::sin(rotation.y);
+        const glm::vec3 axisX{c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1};
+        const glm::vec3 axisY{c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3};
+        const glm::vec3 axisZ{c2 * s1, -s2, c1 * c2};
+        worldMatrix = glm::mat4{
+            glm::vec4{scale.x * axisX, 0.0f},
+            glm::vec4{scale.y * axisY, 0.0f},
+            glm::vec4{scale.z * axisZ, 0.0f},
+            glm::vec4{translation, 1.0f}};
         const glm::vec3 invScale = 1.f / scale;
-        return glm::mat3{
-            {
-                invScale.x * (c1 * c3 + s1 * s2 * s3),
-                invScale.x * (c2 * s3),
-                invScale.x * (c1 * s2 * s3 - c3 * s1)
-            },
-            {
-                invScale.y * (c3 * s1 * s2 - c1 * s3),
-                invScale.y * (c2 * c3),
-                invScale.y * (c1 * c3 * s2 + s1 * s3)
-            },
-            {
-                invScale.z * (c2 * s1),
-                invScale.z * (-s2),
-                invScale.z * (c1 * c2)
-            }
-    };
+        normal = glm::mat3{invScale.x * axisX, invScale.y * axisY, invScale.z * axisZ};
+        dirty = false;
+    }
+
+    const WorldBounds &MeshComponent::getWorldBounds(TransformComponent &transform) {
+        if (boundsValid && model.get() == boundsModel && transform.getVersion() == boundsVersion) {
+            return worldBounds;
+        }
+        boundsValid = true;
+        boundsModel = model.get();
+        boundsVersion = transform.getVersion();
+        if (model == nullptr) {
+            worldBounds = WorldBounds{transform.getTranslation(), 0.f, glm::vec3{0.f}};
+            return worldBounds;
+        }
 
+        const glm::mat4 &modelMatrix = transform.mat4();
+        const LveModel::BoundingBox &box = model->getBoundingBox();
+        const glm::vec4 &sphere = model->getBoundingSphere();
+        // the box's extent along each world axis is the sum of its rotated and scaled half axes
+        const glm::vec3 localExtent = box.halfExtent();
+        const glm::mat3 linear{modelMatrix};
+        worldBounds.center = glm::vec3{modelMatrix * glm::vec4{box.center(), 1.f}};
+        worldBounds.halfExtent = glm::abs(linear[0]) * localExtent.x
+            + glm::abs(linear[1]) * localExtent.y
+            + glm::abs(linear[2]) * localExtent.z;
+        const glm::vec3 absScale = glm::abs(transform.getScale());
+        worldBounds.radius = sphere.w * glm::max(glm::max(absScale.x, absScale.y), absScale.z);
+        return worldBounds;
+    }
+
+    LveEntity createPointLight(LveWorld &world, const glm::vec3 &position, float intensity, float radius, glm::vec3 color) {
+        TransformComponent transform{};
+        transform.setTranslation(position);
+        transform.setScale(glm::vec3{radius, 1.f, 1.f});
+        return world.createEntity(std::move(transform), PointLightComponent{intensity, color});
+    }
 }
-}
\ No newline at end of file
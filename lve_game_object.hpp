@@ -1,16 +1,17 @@
 #pragma once
 
+#include "lve_ecs.hpp"
 #include "lve_model.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cassert>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <utility>
 namespace lve {
-struct TransformComponent {
-    glm::vec3 translation{}; // position offset
-    glm::vec3 rotation{};
-    glm::vec3 scale{1.f, 1.f, 1.f};
+class TransformComponent {
+public:
     // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
     // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
     // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
@@ -24,35 +25,84 @@ struct TransformComponent {
   */
     // yxz euler angle to prevent the gimble lock least as posible
     // because objects look up or down less
-    glm::mat4 mat4();
-    glm::mat3 normalMatrix();
-};
+    // both matrices are cached, the setters mark them dirty and the next call recomputes them together
+    const glm::mat4 &mat4();
+    const glm::mat3 &normalMatrix();
 
+    const glm::vec3 &getTranslation() const { return translation; } // position offset
+    const glm::vec3 &getRotation() const { return rotation; }
+    const glm::vec3 &getScale() const { return scale; }
+    void setTranslation(const glm::vec3 &value) { translation = value; markDirty(); }
+    void setRotation(const glm::vec3 &value) { rotation = value; markDirty(); }
+    void setScale(const glm::vec3 &value) { scale = value; markDirty(); }
 
-class LveGameObject {
-public:
-    using id_t = unsigned int;
-    using Map = std::unordered_map<id_t, LveGameObject>;
+    // a static transform never changes again. Making it static computes its matrices right away,
+    // so every later mat4() and normalMatrix() finds them clean and only returns them. Make the
+    // object static after placing it
+    void setStatic(bool value) {
+        if (value && dirty) update();
+        staticTransform = value;
+    }
+    bool isStatic() const { return staticTransform; }
+    bool isDirty() const { return dirty; }
+    // bumped on every change, lets caches derived from the transform tell whether they are stale
+    uint32_t getVersion() const { return version; }
 
-    static LveGameObject createGameObject() {
-        static id_t currentId = 0;
-        return LveGameObject{currentId++};
+private:
+    void markDirty() {
+        assert(!staticTransform && "static transforms can't be changed");
+        dirty = true;
+        version++;
     }
+    void update();
+
+    glm::vec3 translation{};
+    glm::vec3 rotation{};
+    glm::vec3 scale{1.f, 1.f, 1.f};
 
-    LveGameObject(const LveGameObject &) = delete;
-    LveGameObject &operator=(const LveGameObject &) = delete;
-    LveGameObject(LveGameObject &&) = default;
-    LveGameObject &operator=(LveGameObject &&) = default;
+    glm::mat4 worldMatrix{1.f};
+    glm::mat3 normal{1.f};
+    uint32_t version = 0;
+    bool dirty = true;
+    bool staticTransform = false;
+};
 
-    id_t const getId() { return id; }
+
+// world space bounds of an entity's model, the sphere and the box share their center
+struct WorldBounds {
+    glm::vec3 center{};
+    float radius{0.f};
+    glm::vec3 halfExtent{};
+};
+
+// what the render systems draw, entities with a TransformComponent and a MeshComponent
+class MeshComponent {
+public:
+    MeshComponent() = default;
+    explicit MeshComponent(std::shared_ptr<LveModel> model, uint32_t materialIndex = 0)
+        : model{std::move(model)}, materialIndex{materialIndex} {}
+
+    // recomputed from the model bounds only when the transform or the model changed since the last call
+    const WorldBounds &getWorldBounds(TransformComponent &transform);
 
     std::shared_ptr<LveModel> model{};
-    glm::vec3 color{};
-    TransformComponent transform{};
+    uint32_t materialIndex{0};
 
 private:
-    LveGameObject(id_t objId) : id{objId} {}
+    // what worldBounds was computed from
+    WorldBounds worldBounds{};
+    const LveModel *boundsModel = nullptr;
+    uint32_t boundsVersion = 0;
+    bool boundsValid = false;
+};
 
-    id_t id;
+// the radius is the transform's scale.x
+struct PointLightComponent {
+    float lightIntensity = 1.0f;
+    glm::vec3 color{1.f};
 };
+
+// a point light entity at position, with a TransformComponent and a PointLightComponent
+LveEntity createPointLight(
+    LveWorld &world, const glm::vec3 &position, float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
 } // namespace lve
\ No newline at end of file
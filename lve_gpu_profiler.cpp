@@ -0,0 +1,203 @@
+#include "lve_gpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+
+namespace lve {
+
+LveGpuProfiler::LveGpuProfiler(LveDevice &device, uint32_t frameCount, uint32_t maxZones)
+    : lveDevice{device}, frameCount{frameCount}, maxZones{std::max(maxZones, 1u)} {
+  uint32_t familyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(lveDevice.getPhysicalDevice(), &familyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> families(familyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      lveDevice.getPhysicalDevice(),
+      &familyCount,
+      families.data());
+
+  uint32_t validBits = families[lveDevice.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+  supported = validBits > 0 && lveDevice.properties.limits.timestampPeriod > 0.f;
+  timestampPeriod = lveDevice.properties.limits.timestampPeriod;
+  timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+  createQueryPool();
+}
+
+LveGpuProfiler::~LveGpuProfiler() {
+  if (queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+  }
+}
+
+void LveGpuProfiler::createQueryPool() {
+  if (queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+    queryPool = VK_NULL_HANDLE;
+  }
+  frameZones.assign(frameCount, {});
+  currentFrame = 0;
+  if (!supported) {
+    return;
+  }
+
+  // two timestamps per zone
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = frameCount * maxZones * 2;
+  if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create timestamp query pool!");
+  }
+  timestamps.resize(maxZones * 2);
+}
+
+void LveGpuProfiler::setFrameCount(uint32_t count) {
+  if (count == frameCount) {
+    return;
+  }
+  frameCount = count;
+  createQueryPool();
+}
+
+void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+  assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+  currentFrame = frameIndex;
+  frameZone = UINT32_MAX;
+  if (!supported) {
+    return;
+  }
+
+  collect(frameIndex);
+  vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * maxZones * 2, maxZones * 2);
+  frameZone = beginZone(commandBuffer, FRAME_ZONE);
+}
+
+void LveGpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+  endZone(commandBuffer, frameZone);
+  frameZone = UINT32_MAX;
+}
+
+uint32_t LveGpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char *name) {
+  auto &zones = frameZones[currentFrame];
+  if (!supported || zones.size() == maxZones) {
+    return UINT32_MAX;
+  }
+  uint32_t query = (currentFrame * maxZones + static_cast<uint32_t>(zones.size())) * 2;
+  zones.push_back({name, query});
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+  return static_cast<uint32_t>(zones.size() - 1);
+}
+
+void LveGpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone) {
+  if (zone == UINT32_MAX) {
+    return;
+  }
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      queryPool,
+      frameZones[currentFrame][zone].query + 1);
+}
+
+void LveGpuProfiler::collect(int frameIndex) {
+  auto &zones = frameZones[frameIndex];
+  if (zones.empty()) {
+    return;
+  }
+
+  // the slot's fence has been waited on, so the results are there without VK_QUERY_RESULT_WAIT_BIT
+  uint32_t firstQuery = frameIndex * maxZones * 2;
+  uint32_t queryCount = static_cast<uint32_t>(zones.size()) * 2;
+  VkResult result = vkGetQueryPoolResults(
+      lveDevice.device(),
+      queryPool,
+      firstQuery,
+      queryCount,
+      queryCount * sizeof(uint64_t),
+      timestamps.data(),
+      sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+
+  if (result == VK_SUCCESS) {
+    // zones sharing a name within a frame are summed
+    std::map<std::string, float> frameTotals;
+    for (auto &zone : zones) {
+      uint32_t local = zone.query - firstQuery;
+      uint64_t ticks = (timestamps[local + 1] - timestamps[local]) & timestampMask;
+      frameTotals[zone.name] += static_cast<float>(ticks * timestampPeriod / 1e6);
+    }
+    for (auto &kv : frameTotals) {
+      auto &zoneHistory = history[kv.first];
+      zoneHistory.samples[zoneHistory.next] = kv.second;
+      zoneHistory.next = (zoneHistory.next + 1) % HISTORY_SIZE;
+      zoneHistory.count = std::min(zoneHistory.count + 1, HISTORY_SIZE);
+    }
+  }
+  zones.clear();
+}
+
+LveGpuProfiler::Stats LveGpuProfiler::getStats(const std::string &name) const {
+  Stats stats{};
+  auto it = history.find(name);
+  if (it == history.end() || it->second.count == 0) {
+    return stats;
+  }
+
+  std::vector<float> sorted(it->second.samples.begin(), it->second.samples.begin() + it->second.count);
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&](float p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+  };
+
+  float sum = 0.f;
+  for (float sample : sorted) {
+    sum += sample;
+  }
+  stats.sampleCount = static_cast<uint32_t>(sorted.size());
+  stats.averageMs = sum / sorted.size();
+  stats.p50Ms = percentile(0.50f);
+  stats.p95Ms = percentile(0.95f);
+  stats.p99Ms = percentile(0.99f);
+  stats.maxMs = sorted.back();
+  return stats;
+}
+
+float LveGpuProfiler::getLatestMs(const std::string &name) const {
+  auto it = history.find(name);
+  if (it == history.end() || it->second.count == 0) {
+    return 0.f;
+  }
+  return it->second.samples[(it->second.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+}
+
+std::string LveGpuProfiler::report() const {
+  std::vector<std::string> names;
+  for (auto &kv : history) {
+    names.push_back(kv.first);
+  }
+  std::sort(names.begin(), names.end());
+
+  std::string text;
+  char line[160];
+  for (auto &name : names) {
+    Stats stats = getStats(name);
+    snprintf(
+        line,
+        sizeof(line),
+        "%-24s avg %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms\n",
+        name.c_str(),
+        stats.averageMs,
+        stats.p50Ms,
+        stats.p95Ms,
+        stats.p99Ms,
+        stats.maxMs);
+    text += line;
+  }
+  return text;
+}
+
+}  // namespace lve
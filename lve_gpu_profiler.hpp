@@ -0,0 +1,113 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+/*
+ * GPU timings from timestamp queries.
+ *
+ * Every frame in flight owns a range of a query pool. A frame's results are read back when its
+ * slot comes around again in beginFrame, after the renderer waited for that slot's fence, so the
+ * readback never stalls. Zones are identified by name; the same name used several times in a frame
+ * is summed. The whole frame is always recorded as the "frame" zone.
+ */
+class LveGpuProfiler {
+ public:
+  static constexpr uint32_t DEFAULT_MAX_ZONES = 64;
+  static constexpr size_t HISTORY_SIZE = 256;
+  static constexpr const char *FRAME_ZONE = "frame";
+
+  struct Stats {
+    float averageMs = 0.f;
+    float p50Ms = 0.f;
+    float p95Ms = 0.f;
+    float p99Ms = 0.f;
+    float maxMs = 0.f;
+    uint32_t sampleCount = 0;
+  };
+
+  LveGpuProfiler(LveDevice &device, uint32_t frameCount, uint32_t maxZones = DEFAULT_MAX_ZONES);
+  ~LveGpuProfiler();
+
+  LveGpuProfiler(const LveGpuProfiler &) = delete;
+  LveGpuProfiler &operator=(const LveGpuProfiler &) = delete;
+
+  // recreates the query pool, only while no frame is in flight
+  void setFrameCount(uint32_t count);
+
+  // collects the results the slot produced last time, then resets it. Must be recorded outside a
+  // render pass, right after the command buffer was begun
+  void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+  // closes the frame zone, call before the command buffer is ended
+  void endFrame(VkCommandBuffer commandBuffer);
+
+  // name must outlive the frame, string literals are expected. Returns UINT32_MAX when the zone
+  // limit was reached or timestamps are unsupported
+  uint32_t beginZone(VkCommandBuffer commandBuffer, const char *name);
+  void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+  bool isSupported() const { return supported; }
+  Stats getStats(const std::string &name) const;
+  // most recent frame that was read back, 0 before the first one
+  float getLatestMs(const std::string &name) const;
+  // one line per zone, averages and percentiles in milliseconds
+  std::string report() const;
+
+ private:
+  struct Zone {
+    const char *name;
+    uint32_t query;
+  };
+
+  struct History {
+    std::array<float, HISTORY_SIZE> samples{};
+    size_t count = 0;
+    size_t next = 0;
+  };
+
+  void createQueryPool();
+  void collect(int frameIndex);
+
+  LveDevice &lveDevice;
+  uint32_t frameCount;
+  uint32_t maxZones;
+  bool supported = false;
+  float timestampPeriod = 1.f;
+  uint64_t timestampMask = ~0ull;
+
+  VkQueryPool queryPool = VK_NULL_HANDLE;
+  // zones recorded by each frame slot, waiting for readback
+  std::vector<std::vector<Zone>> frameZones;
+  int currentFrame = 0;
+  uint32_t frameZone = UINT32_MAX;
+
+  std::vector<uint64_t> timestamps;
+  std::unordered_map<std::string, History> history;
+};
+
+// records a zone for the lifetime of the object
+class LveGpuZone {
+ public:
+  LveGpuZone(LveGpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name)
+      : profiler{profiler}, commandBuffer{commandBuffer} {
+    zone = profiler.beginZone(commandBuffer, name);
+  }
+  ~LveGpuZone() { profiler.endZone(commandBuffer, zone); }
+
+  LveGpuZone(const LveGpuZone &) = delete;
+  LveGpuZone &operator=(const LveGpuZone &) = delete;
+
+ private:
+  LveGpuProfiler &profiler;
+  VkCommandBuffer commandBuffer;
+  uint32_t zone;
+};
+
+}  // namespace lve
@@ -0,0 +1,134 @@
+#include "lve_indirect_buffer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+LveIndirectBuffer::LveIndirectBuffer(LveDevice &device, uint32_t frameCount, uint32_t capacity)
+    : lveDevice{device}, frameCount{frameCount}, capacity{std::max(capacity, 1u)} {
+  createBuffers();
+}
+
+LveIndirectBuffer::~LveIndirectBuffer() {}
+
+void LveIndirectBuffer::createBuffers() {
+  if (commandBuffer) {
+    std::shared_ptr<LveBuffer> oldCommands = std::move(commandBuffer);
+    std::shared_ptr<LveBuffer> oldCounts = std::move(countBuffer);
+    lveDevice.deletionQueue().push([oldCommands, oldCounts]() {});
+  }
+  // storage usage so a compute pass can write commands and counts
+  commandBuffer = std::make_unique<LveBuffer>(
+      lveDevice,
+      capacity * sizeof(VkDrawIndexedIndirectCommand),
+      frameCount,
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+      lveDevice.properties.limits.minStorageBufferOffsetAlignment);
+  commandBuffer->map();
+  commandStride = commandBuffer->getAlignmentSize();
+
+  countBuffer = std::make_unique<LveBuffer>(
+      lveDevice,
+      groupCapacity * sizeof(uint32_t),
+      frameCount,
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+      lveDevice.properties.limits.minStorageBufferOffsetAlignment);
+  countBuffer->map();
+  countStride = countBuffer->getAlignmentSize();
+}
+
+void LveIndirectBuffer::setFrameCount(uint32_t count) {
+  if (count == frameCount) {
+    return;
+  }
+  frameCount = count;
+  currentFrame = 0;
+  commandCount = 0;
+  groups.clear();
+  createBuffers();
+}
+
+void LveIndirectBuffer::beginFrame(int frameIndex, uint32_t commandCount, uint32_t groupCount) {
+  assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+  if (commandCount > capacity || groupCount > groupCapacity) {
+    if (commandCount > capacity) capacity = std::max(commandCount, capacity * 2);
+    if (groupCount > groupCapacity) groupCapacity = std::max(groupCount, groupCapacity * 2);
+    createBuffers();
+  }
+  currentFrame = frameIndex;
+  this->commandCount = 0;
+  groups.clear();
+}
+
+uint32_t LveIndirectBuffer::beginGroup() {
+  if (groups.size() == groupCapacity) {
+    throw std::runtime_error("too many indirect draw groups, pass the group count to beginFrame");
+  }
+  groups.push_back({commandCount, 0, 0});
+  return static_cast<uint32_t>(groups.size() - 1);
+}
+
+void LveIndirectBuffer::add(const VkDrawIndexedIndirectCommand &command) {
+  assert(!groups.empty() && "Call beginGroup before adding commands");
+  assert(commandCount < capacity && "Indirect buffer overflow, pass the command count to beginFrame");
+  char *frameData =
+      static_cast<char *>(commandBuffer->getMappedMemory()) + getFrameOffset(currentFrame);
+  memcpy(
+      frameData + commandCount * sizeof(VkDrawIndexedIndirectCommand),
+      &command,
+      sizeof(VkDrawIndexedIndirectCommand));
+  commandCount++;
+  groups.back().commandCount++;
+  groups.back().drawCount++;
+}
+
+void LveIndirectBuffer::flush() {
+  if (groups.empty()) {
+    return;
+  }
+  auto *counts = reinterpret_cast<uint32_t *>(
+      static_cast<char *>(countBuffer->getMappedMemory()) + getCountOffset(currentFrame));
+  for (size_t i = 0; i < groups.size(); i++) {
+    counts[i] = groups[i].drawCount;
+  }
+  countBuffer->flush(groups.size() * sizeof(uint32_t), getCountOffset(currentFrame));
+  if (commandCount > 0) {
+    commandBuffer->flush(
+        commandCount * sizeof(VkDrawIndexedIndirectCommand), getFrameOffset(currentFrame));
+  }
+}
+
+void LveIndirectBuffer::draw(VkCommandBuffer cmd, uint32_t group) const {
+  const Group &drawGroup = groups[group];
+  if (drawGroup.commandCount == 0) {
+    return;
+  }
+  constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  VkDeviceSize offset = getFrameOffset(currentFrame) + drawGroup.firstCommand * stride;
+
+  if (lveDevice.cmdDrawIndexedIndirectCount) {
+    lveDevice.cmdDrawIndexedIndirectCount(
+        cmd,
+        commandBuffer->getBuffer(),
+        offset,
+        countBuffer->getBuffer(),
+        getCountOffset(currentFrame) + group * sizeof(uint32_t),
+        drawGroup.commandCount,
+        stride);
+  } else if (lveDevice.enabledFeatures.multiDrawIndirect) {
+    vkCmdDrawIndexedIndirect(cmd, commandBuffer->getBuffer(), offset, drawGroup.commandCount, stride);
+  } else {
+    // the parameters still come from the buffer, only the call count grows with the groups
+    for (uint32_t i = 0; i < drawGroup.commandCount; i++) {
+      vkCmdDrawIndexedIndirect(cmd, commandBuffer->getBuffer(), offset + i * stride, 1, stride);
+    }
+  }
+}
+
+}  // namespace lve
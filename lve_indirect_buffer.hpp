@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Per-frame list of VkDrawIndexedIndirectCommand for the draws of a frame.
+ *
+ * Commands are appended in groups; a group is a contiguous run of commands that share their vertex
+ * and index buffers (one mesh pool page) and is issued with a single indirect draw. Every group
+ * also has a draw count slot in a separate buffer. The count variant
+ * (vkCmdDrawIndexedIndirectCountKHR) reads it when the device has VK_KHR_draw_indirect_count.
+ * Without multiDrawIndirect a group falls back to one indirect call per command. firstInstance of
+ * every command is the index of its first object in LveObjectBuffer, which the shaders read
+ * through gl_InstanceIndex. Culled commands start with no instances instead and a compute pass
+ * raises instanceCount, their firstInstance points into LveObjectBuffer's instance table (see
+ * GpuCullSystem).
+ *
+ * Like LveObjectBuffer, every frame in flight owns a region of a persistently mapped buffer.
+ */
+class LveIndirectBuffer {
+ public:
+  static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+  static constexpr uint32_t DEFAULT_GROUP_CAPACITY = 64;
+
+  LveIndirectBuffer(LveDevice &device, uint32_t frameCount, uint32_t capacity = DEFAULT_CAPACITY);
+  ~LveIndirectBuffer();
+
+  LveIndirectBuffer(const LveIndirectBuffer &) = delete;
+  LveIndirectBuffer &operator=(const LveIndirectBuffer &) = delete;
+
+  // non zero firstInstance in indirect commands needs drawIndirectFirstInstance
+  static bool isSupported(LveDevice &device) {
+    return device.enabledFeatures.drawIndirectFirstInstance == VK_TRUE;
+  }
+
+  // reallocates with one region per frame, only while no frame is in flight
+  void setFrameCount(uint32_t count);
+  // rewinds the frame's region, grows the buffers first if commandCount or groupCount do not fit.
+  // Growing drops the old buffers through the deletion queue, frames in flight keep reading them
+  void beginFrame(int frameIndex, uint32_t commandCount, uint32_t groupCount = 0);
+  // later commands go into a new group, returns its index. Throws when the groups outgrow the
+  // count region, pass the group count to beginFrame
+  uint32_t beginGroup();
+  void add(const VkDrawIndexedIndirectCommand &command);
+  // writes the group counts and flushes the frame's region
+  void flush();
+
+  void draw(VkCommandBuffer commandBuffer, uint32_t group) const;
+
+  uint32_t getGroupCount() const { return static_cast<uint32_t>(groups.size()); }
+  uint32_t getCommandCount() const { return commandCount; }
+  VkBuffer getBuffer() const { return commandBuffer->getBuffer(); }
+  VkBuffer getCountBuffer() const { return countBuffer->getBuffer(); }
+  VkDeviceSize getFrameOffset(int frameIndex) const { return frameIndex * commandStride; }
+  VkDeviceSize getCountOffset(int frameIndex) const { return frameIndex * countStride; }
+  VkDeviceSize getFrameSize() const { return capacity * sizeof(VkDrawIndexedIndirectCommand); }
+  VkDeviceSize getCountFrameSize() const { return groupCapacity * sizeof(uint32_t); }
+
+ private:
+  struct Group {
+    uint32_t firstCommand;
+    // the group's range, the upper bound for the draw count
+    uint32_t commandCount;
+    // commands written on the cpu, what the count buffer starts with
+    uint32_t drawCount;
+  };
+
+  void createBuffers();
+
+  LveDevice &lveDevice;
+  uint32_t frameCount;
+  uint32_t capacity;
+  uint32_t groupCapacity = DEFAULT_GROUP_CAPACITY;
+  VkDeviceSize commandStride = 0;
+  VkDeviceSize countStride = 0;
+
+  std::unique_ptr<LveBuffer> commandBuffer;
+  std::unique_ptr<LveBuffer> countBuffer;
+
+  int currentFrame = 0;
+  uint32_t commandCount = 0;
+  std::vector<Group> groups;
+};
+
+}  // namespace lve
@@ -0,0 +1,126 @@
+#include "lve_mesh_pool.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace lve {
+
+bool LveMeshPool::RangeList::allocate(uint32_t count, uint32_t &first) {
+  if (count == 0) {
+    first = 0;
+    return true;
+  }
+  for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+    if (it->second < count) {
+      continue;
+    }
+    first = it->first;
+    uint32_t remaining = it->second - count;
+    freeRanges.erase(it);
+    if (remaining > 0) {
+      freeRanges[first + count] = remaining;
+    }
+    return true;
+  }
+  return false;
+}
+
+void LveMeshPool::RangeList::free(uint32_t first, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto next = freeRanges.lower_bound(first);
+  if (next != freeRanges.end() && first + count == next->first) {
+    count += next->second;
+    next = freeRanges.erase(next);
+  }
+  if (next != freeRanges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == first) {
+      prev->second += count;
+      return;
+    }
+  }
+  freeRanges[first] = count;
+}
+
+LveMeshPool::LveMeshPool(
+    LveDevice &device, VkDeviceSize vertexStride, uint32_t pageVertices, uint32_t pageIndices)
+    : lveDevice{device},
+      vertexStride{vertexStride},
+      pageVertices{pageVertices},
+      pageIndices{pageIndices} {}
+
+LveMeshPool::~LveMeshPool() {}
+
+uint32_t LveMeshPool::createPage(uint32_t vertexCapacity, uint32_t indexCapacity) {
+  auto page = std::make_unique<Page>(Page{
+      std::make_unique<LveBuffer>(
+          lveDevice,
+          vertexStride,
+          vertexCapacity,
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+      std::make_unique<LveBuffer>(
+          lveDevice,
+          sizeof(uint32_t),
+          std::max(indexCapacity, 1u),
+          VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+      RangeList{vertexCapacity},
+      RangeList{indexCapacity}});
+  pages.push_back(std::move(page));
+  return static_cast<uint32_t>(pages.size() - 1);
+}
+
+LveMeshPool::Range LveMeshPool::allocate(uint32_t vertexCount, uint32_t indexCount) {
+  assert(vertexCount > 0 && "Cannot allocate an empty mesh");
+
+  Range range{};
+  range.vertexCount = vertexCount;
+  range.indexCount = indexCount;
+
+  auto tryPage = [&](uint32_t page) {
+    uint32_t firstVertex;
+    if (!pages[page]->vertexRanges.allocate(vertexCount, firstVertex)) {
+      return false;
+    }
+    if (!pages[page]->indexRanges.allocate(indexCount, range.firstIndex)) {
+      pages[page]->vertexRanges.free(firstVertex, vertexCount);
+      return false;
+    }
+    range.page = page;
+    range.vertexOffset = static_cast<int32_t>(firstVertex);
+    return true;
+  };
+
+  for (uint32_t page = 0; page < pages.size(); page++) {
+    if (tryPage(page)) {
+      return range;
+    }
+  }
+
+  uint32_t page = createPage(std::max(vertexCount, pageVertices), std::max(indexCount, pageIndices));
+  if (!tryPage(page)) {
+    throw std::runtime_error("failed to allocate mesh pool range!");
+  }
+  return range;
+}
+
+void LveMeshPool::free(const Range &range) {
+  assert(range.page < pages.size() && "Range does not belong to this pool");
+  pages[range.page]->vertexRanges.free(static_cast<uint32_t>(range.vertexOffset), range.vertexCount);
+  pages[range.page]->indexRanges.free(range.firstIndex, range.indexCount);
+}
+
+void LveMeshPool::bind(VkCommandBuffer commandBuffer, uint32_t page) {
+  VkBuffer buffers[] = {getVertexBuffer(page)};
+  VkDeviceSize offsets[] = {0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, getIndexBuffer(page), 0, VK_INDEX_TYPE_UINT32);
+}
+
+}  // namespace lve
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Shared vertex and index storage for static meshes.
+ *
+ * Meshes are packed into a few large pages, each holding one vertex and one index buffer. A model
+ * stored here only keeps its Range (vertexOffset, firstIndex and counts), so consecutive draws from
+ * the same page need no rebinding and the whole scene can later be drawn with indirect commands.
+ * Pages are created on demand; a mesh that does not fit in a default page gets one sized for it.
+ */
+class LveMeshPool {
+ public:
+  static constexpr uint32_t DEFAULT_PAGE_VERTICES = 512 * 1024;
+  static constexpr uint32_t DEFAULT_PAGE_INDICES = 2 * 1024 * 1024;
+
+  struct Range {
+    uint32_t page = 0;
+    int32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+  };
+
+  LveMeshPool(
+      LveDevice &device,
+      VkDeviceSize vertexStride,
+      uint32_t pageVertices = DEFAULT_PAGE_VERTICES,
+      uint32_t pageIndices = DEFAULT_PAGE_INDICES);
+  ~LveMeshPool();
+
+  LveMeshPool(const LveMeshPool &) = delete;
+  LveMeshPool &operator=(const LveMeshPool &) = delete;
+
+  Range allocate(uint32_t vertexCount, uint32_t indexCount);
+  // the range must no longer be referenced by any command buffer in flight
+  void free(const Range &range);
+
+  VkBuffer getVertexBuffer(uint32_t page) const { return pages[page]->vertexBuffer->getBuffer(); }
+  VkBuffer getIndexBuffer(uint32_t page) const { return pages[page]->indexBuffer->getBuffer(); }
+  VkDeviceSize getVertexStride() const { return vertexStride; }
+  uint32_t getPageCount() const { return static_cast<uint32_t>(pages.size()); }
+
+  void bind(VkCommandBuffer commandBuffer, uint32_t page);
+
+ private:
+  // first fit over a sorted free list, adjacent ranges are merged on release
+  class RangeList {
+   public:
+    explicit RangeList(uint32_t capacity) { freeRanges[0] = capacity; }
+    bool allocate(uint32_t count, uint32_t &first);
+    void free(uint32_t first, uint32_t count);
+
+   private:
+    std::map<uint32_t, uint32_t> freeRanges;
+  };
+
+  struct Page {
+    std::unique_ptr<LveBuffer> vertexBuffer;
+    std::unique_ptr<LveBuffer> indexBuffer;
+    RangeList vertexRanges;
+    RangeList indexRanges;
+  };
+
+  uint32_t createPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+  LveDevice &lveDevice;
+  VkDeviceSize vertexStride;
+  uint32_t pageVertices;
+  uint32_t pageIndices;
+  std::vector<std::unique_ptr<Page>> pages;
+};
+
+}  // namespace lve
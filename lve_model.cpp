@@ -1,5 +1,6 @@
 #include "lve_model.hpp"
 #include "lve_utils.hpp"
+#include "lve_profiler.hpp"
 
 // libs
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -26,116 +27,73 @@ struct hash<lve::LveModel::Vertex> {
 
 namespace lve {
 
-LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDevice{device} {
-    createVertexBuffers(builder.vertices);
-    createIndexBuffers(builder.indices);
+LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder, LveUploadBatch *uploadBatch, LveMeshPool *meshPool)
+    : lveDevice{device}, boundingBox{builder.boundingBox}, boundingSphere{builder.boundingSphere}, meshPool{meshPool} {
+    // vertex and index copies still share one submit
+    std::unique_ptr<LveUploadBatch> localBatch;
+    if (uploadBatch == nullptr) {
+        localBatch = std::make_unique<LveUploadBatch>(lveDevice);
+        uploadBatch = localBatch.get();
+    }
+
+    if (meshPool != nullptr) {
+        createPooledBuffers(builder, *uploadBatch);
+    } else {
+        createVertexBuffers(builder.vertices, *uploadBatch);
+        createIndexBuffers(builder.indices, *uploadBatch);
+    }
+
+    if (localBatch) {
+        localBatch->submitAndWait();
+    }
 }
 LveModel::~LveModel() {
+    // frames in flight may still draw this model
+    if (meshPool != nullptr) {
+        LveMeshPool *pool = meshPool;
+        LveMeshPool::Range range = meshRange;
+        lveDevice.deletionQueue().push([pool, range]() { pool->free(range); });
+    }
+    std::shared_ptr<LveBuffer> vertices = std::move(vertexBuffer);
+    std::shared_ptr<LveBuffer> indices = std::move(indexBuffer);
+    if (vertices || indices) {
+        lveDevice.deletionQueue().push([vertices, indices]() {});
+    }
 }
 
 
 
-std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath) {
+std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath, LveUploadBatch *uploadBatch, LveMeshPool *meshPool) {
+    LVE_PROFILE_FUNCTION();
     Builder builder{};
     builder.loadModel(filepath);
     std::cout << "Vertex count: " << builder.vertices.size() << "\n";
-    return std::make_unique<LveModel>(device, builder);
+    return std::make_unique<LveModel>(device, builder, uploadBatch, meshPool);
 }
 
-std::unique_ptr<LveModel> LveModel::loadHeightMap(LveDevice &device, const std::vector<std::vector<float>>& heightMap){
-
+std::unique_ptr<LveModel> LveModel::loadHeightMap(LveDevice &device, const std::vector<std::vector<float>>& heightMap, LveUploadBatch *uploadBatch, LveMeshPool *meshPool){
+    LVE_PROFILE_FUNCTION();
     Builder builder{};
-    float scale = 1.0f; // Scale for the grid spacing
-    float heightScale = 1.0f; // Scale for the height values
-
-    size_t rows = heightMap.size();
-    size_t cols = heightMap.empty() ? 0 : heightMap[0].size();
-      for (size_t z = 0; z < rows; ++z) {
-        for (size_t x = 0; x < cols; ++x) {
-            float height = heightMap[z][x];
-
-            Vertex vertex{};
-            vertex.position = glm::vec3(x * scale, height * heightScale, z * scale);
-            vertex.color = glm::vec3(1.0f); // Placeholder color
-            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f); // Placeholder normal
-            vertex.uv = glm::vec2(x / static_cast<float>(cols), z / static_cast<float>(rows));
-
-            builder.vertices.push_back(vertex);
-        }
-    }
-        // Generate indices (for a grid of quads)
-    for (size_t z = 0; z < rows - 1; ++z) {
-        for (size_t x = 0; x < cols - 1; ++x) {
-            uint32_t topLeft = z * cols + x;
-            uint32_t topRight = topLeft + 1;
-            uint32_t bottomLeft = (z + 1) * cols + x;
-            uint32_t bottomRight = bottomLeft + 1;
-
-            builder.indices.push_back(topLeft);
-            builder.indices.push_back(bottomLeft);
-            builder.indices.push_back(topRight);
-
-            builder.indices.push_back(topRight);
-            builder.indices.push_back(bottomLeft);
-            builder.indices.push_back(bottomRight);
-        }
-    }
-
-    for (size_t z = 0; z < rows; ++z) {
-        for (size_t x = 0; x < cols; ++x) {
-            glm::vec3 sumNormals(0.0f);
-
-            // Neighbors
-            glm::vec3 left = x > 0 ?
-                glm::vec3(-1.0f, heightMap[z][x - 1] - heightMap[z][x], 0.0f) : glm::vec3(0.0f);
-            glm::vec3 right = x < rows - 1 ?
-                glm::vec3(1.0f, heightMap[z][x + 1] - heightMap[z][x], 0.0f) : glm::vec3(0.0f);
-            glm::vec3 down = z > 0 ?
-                glm::vec3(0.0f, heightMap[z - 1][x] - heightMap[z][x], -1.0f) : glm::vec3(0.0f);
-            glm::vec3 up = z < rows - 1 ?
-                glm::vec3(0.0f, heightMap[z + 1][x] - heightMap[z][x], 1.0f) : glm::vec3(0.0f);
-
-            // Cross products to compute normals
-            if (x > 0 && z > 0) sumNormals += glm::cross(left, down);
-            if (x < rows - 1 && z > 0) sumNormals += glm::cross(down, right);
-            if (x < rows - 1 && z < rows - 1) sumNormals += glm::cross(right, up);
-            if (x > 0 && z < rows - 1) sumNormals += glm::cross(up, left);
-
-            // Assign and normalize the normal
-            builder.vertices[z * rows + x].normal = glm::normalize(sumNormals);
-        }
-    }
-    return std::make_unique<LveModel>(device, builder);
-
+    builder.loadHeightMap(heightMap);
+    return std::make_unique<LveModel>(device, builder, uploadBatch, meshPool);
 }
 
-void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
+void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices, LveUploadBatch &uploadBatch) {
     vertexCount = static_cast<uint32_t>(vertices.size());
     assert(vertexCount >= 3 && "Vertex count must be at least 3");
     VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
     uint32_t vertexSize = sizeof(vertices[0]);
 
-    LveBuffer stagingBuffer{
-        lveDevice,
-        vertexSize,
-        vertexCount,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-    };
-
-    stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)vertices.data());
-
     vertexBuffer = std::make_unique<LveBuffer>(
         lveDevice,
         vertexSize,
         vertexCount,
         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+    uploadBatch.uploadBuffer(vertices.data(), bufferSize, vertexBuffer->getBuffer());
 }
 
-void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
+void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices, LveUploadBatch &uploadBatch) {
     indexCount = static_cast<uint32_t>(indices.size());
     hasIndexBuffer = indexCount > 0;
 
@@ -147,17 +105,6 @@ void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
     VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
     uint32_t indexSize = sizeof(indices[0]);
 
-    LveBuffer stagingBuffer = {
-        lveDevice,
-        indexSize,
-        indexCount,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-    };
-
-    stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)indices.data());
-
     indexBuffer = std::make_unique<LveBuffer>(
         lveDevice,
         indexSize,
@@ -165,17 +112,46 @@ void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
         VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    lveDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+    uploadBatch.uploadBuffer(indices.data(), bufferSize, indexBuffer->getBuffer());
 }
 
-void LveModel::draw(VkCommandBuffer commandBuffer) {
+void LveModel::createPooledBuffers(const Builder &builder, LveUploadBatch &uploadBatch) {
+    vertexCount = static_cast<uint32_t>(builder.vertices.size());
+    indexCount = static_cast<uint32_t>(builder.indices.size());
+    hasIndexBuffer = indexCount > 0;
+    assert(vertexCount >= 3 && "Vertex count must be at least 3");
+    assert(meshPool->getVertexStride() == sizeof(Vertex) && "Mesh pool stride does not match Vertex");
+
+    meshRange = meshPool->allocate(vertexCount, indexCount);
+    uploadBatch.uploadBuffer(
+        builder.vertices.data(),
+        sizeof(Vertex) * vertexCount,
+        meshPool->getVertexBuffer(meshRange.page),
+        sizeof(Vertex) * static_cast<VkDeviceSize>(meshRange.vertexOffset));
     if (hasIndexBuffer) {
-        vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+        uploadBatch.uploadBuffer(
+            builder.indices.data(),
+            sizeof(uint32_t) * indexCount,
+            meshPool->getIndexBuffer(meshRange.page),
+            sizeof(uint32_t) * static_cast<VkDeviceSize>(meshRange.firstIndex));
+    }
+}
+
+void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t firstInstance, uint32_t instanceCount) {
+    if (hasIndexBuffer) {
+        vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, meshRange.firstIndex, meshRange.vertexOffset, firstInstance);
     } else {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+        vkCmdDraw(commandBuffer, vertexCount, instanceCount, static_cast<uint32_t>(meshRange.vertexOffset), firstInstance);
     }
 }
+VkBuffer LveModel::getVertexBuffer() const {
+    return meshPool != nullptr ? meshPool->getVertexBuffer(meshRange.page) : vertexBuffer->getBuffer();
+}
 void LveModel::bind(VkCommandBuffer commandBuffer) {
+    if (meshPool != nullptr) {
+        meshPool->bind(commandBuffer, meshRange.page);
+        return;
+    }
     VkBuffer buffers[] = {vertexBuffer->getBuffer()};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
@@ -255,6 +231,93 @@ void LveModel::Builder::loadModel(const std::string &filepath) {
             indices.push_back(uniqueVertices[vertex]);
         }
     }
+    computeBounds();
+}
+
+void LveModel::Builder::loadHeightMap(const std::vector<std::vector<float>>& heightMap) {
+    vertices.clear();
+    indices.clear();
+
+    float scale = 1.0f; // Scale for the grid spacing
+    float heightScale = 1.0f; // Scale for the height values
+
+    size_t rows = heightMap.size();
+    size_t cols = heightMap.empty() ? 0 : heightMap[0].size();
+      for (size_t z = 0; z < rows; ++z) {
+        for (size_t x = 0; x < cols; ++x) {
+            float height = heightMap[z][x];
+
+            Vertex vertex{};
+            vertex.position = glm::vec3(x * scale, height * heightScale, z * scale);
+            vertex.color = glm::vec3(1.0f); // Placeholder color
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f); // Placeholder normal
+            vertex.uv = glm::vec2(x / static_cast<float>(cols), z / static_cast<float>(rows));
+
+            vertices.push_back(vertex);
+        }
+    }
+        // Generate indices (for a grid of quads)
+    for (size_t z = 0; z < rows - 1; ++z) {
+        for (size_t x = 0; x < cols - 1; ++x) {
+            uint32_t topLeft = z * cols + x;
+            uint32_t topRight = topLeft + 1;
+            uint32_t bottomLeft = (z + 1) * cols + x;
+            uint32_t bottomRight = bottomLeft + 1;
+
+            indices.push_back(topLeft);
+            indices.push_back(bottomLeft);
+            indices.push_back(topRight);
+
+            indices.push_back(topRight);
+            indices.push_back(bottomLeft);
+            indices.push_back(bottomRight);
+        }
+    }
+
+    for (size_t z = 0; z < rows; ++z) {
+        for (size_t x = 0; x < cols; ++x) {
+            glm::vec3 sumNormals(0.0f);
+
+            // Neighbors
+            glm::vec3 left = x > 0 ?
+                glm::vec3(-1.0f, heightMap[z][x - 1] - heightMap[z][x], 0.0f) : glm::vec3(0.0f);
+            glm::vec3 right = x < rows - 1 ?
+                glm::vec3(1.0f, heightMap[z][x + 1] - heightMap[z][x], 0.0f) : glm::vec3(0.0f);
+            glm::vec3 down = z > 0 ?
+                glm::vec3(0.0f, heightMap[z - 1][x] - heightMap[z][x], -1.0f) : glm::vec3(0.0f);
+            glm::vec3 up = z < rows - 1 ?
+                glm::vec3(0.0f, heightMap[z + 1][x] - heightMap[z][x], 1.0f) : glm::vec3(0.0f);
+
+            // Cross products to compute normals
+            if (x > 0 && z > 0) sumNormals += glm::cross(left, down);
+            if (x < rows - 1 && z > 0) sumNormals += glm::cross(down, right);
+            if (x < rows - 1 && z < rows - 1) sumNormals += glm::cross(right, up);
+            if (x > 0 && z < rows - 1) sumNormals += glm::cross(up, left);
+
+            // Assign and normalize the normal
+            vertices[z * rows + x].normal = glm::normalize(sumNormals);
+        }
+    }
+    computeBounds();
+}
+
+void LveModel::Builder::computeBounds() {
+    boundingBox = BoundingBox{};
+    boundingSphere = glm::vec4{0.f};
+    if (vertices.empty()) return;
+    // the sphere is centered on the box, not the minimal one, but one pass over the vertices each
+    boundingBox.min = vertices[0].position;
+    boundingBox.max = vertices[0].position;
+    for (auto &vertex : vertices) {
+        boundingBox.min = glm::min(boundingBox.min, vertex.position);
+        boundingBox.max = glm::max(boundingBox.max, vertex.position);
+    }
+    glm::vec3 center = boundingBox.center();
+    float radius = 0.f;
+    for (auto &vertex : vertices) {
+        radius = glm::max(radius, glm::length(vertex.position - center));
+    }
+    boundingSphere = glm::vec4{center, radius};
 }
 
 } // namespace lve
\ No newline at end of file
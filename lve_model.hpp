@@ -2,6 +2,8 @@
 
 #include "lve_buffer.hpp"
 #include "lve_device.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_upload_batch.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -31,30 +33,66 @@ namespace lve
 
     };
 
+    // axis aligned, in model space
+    struct BoundingBox {
+        glm::vec3 min{0.f};
+        glm::vec3 max{0.f};
+
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 halfExtent() const { return (max - min) * 0.5f; }
+    };
+
     struct Builder {
         std::vector<Vertex> vertices {};
         std::vector<uint32_t> indices {};
+        // filled in by the loaders, call computeBounds after filling the vertices by hand
+        BoundingBox boundingBox{};
+        // center of boundingBox in xyz, distance to the farthest vertex in w
+        glm::vec4 boundingSphere{0.f};
 
         void loadModel(const std::string &filepath);
         void loadHeightMap(const std::vector<std::vector<float>>& heightMap);
+        void computeBounds();
 
     };
 
-        LveModel(LveDevice &device, const LveModel::Builder& builder);
+        // with an upload batch the copies are only recorded, the caller submits the batch
+        // before the model is drawn. Without one the model uploads and waits on its own.
+        // With a mesh pool the geometry goes into the pool's shared buffers instead of its own.
+        LveModel(LveDevice &device, const LveModel::Builder& builder, LveUploadBatch *uploadBatch = nullptr, LveMeshPool *meshPool = nullptr);
         ~LveModel();
         LveModel(const LveModel &) = delete;
         LveModel &operator=(const LveModel &) = delete;
 
-        static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath);
-        static std::unique_ptr<LveModel> loadHeightMap(LveDevice &device, const std::vector<std::vector<float>>& heightMap);
+        static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath, LveUploadBatch *uploadBatch = nullptr, LveMeshPool *meshPool = nullptr);
+        static std::unique_ptr<LveModel> loadHeightMap(LveDevice &device, const std::vector<std::vector<float>>& heightMap, LveUploadBatch *uploadBatch = nullptr, LveMeshPool *meshPool = nullptr);
 
         void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        // firstInstance picks the object in the per-frame object buffer
+        void draw(VkCommandBuffer commandBuffer, uint32_t firstInstance = 0, uint32_t instanceCount = 1);
+
+        // models sharing a vertex buffer can be drawn back to back without binding again
+        VkBuffer getVertexBuffer() const;
+        bool isPooled() const { return meshPool != nullptr; }
+        const LveMeshPool::Range &getMeshRange() const { return meshRange; }
+        bool hasIndices() const { return hasIndexBuffer; }
+        uint32_t getVertexCount() const { return vertexCount; }
+        uint32_t getIndexCount() const { return indexCount; }
+        // model space bounds of the vertices, as computed by the builder
+        const BoundingBox &getBoundingBox() const { return boundingBox; }
+        // center of the bounding box in xyz, distance to the farthest vertex in w (model space)
+        const glm::vec4 &getBoundingSphere() const { return boundingSphere; }
     private:
 
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        void createVertexBuffers(const std::vector<Vertex> &vertices, LveUploadBatch &uploadBatch);
+        void createIndexBuffers(const std::vector<uint32_t> &indices, LveUploadBatch &uploadBatch);
+        void createPooledBuffers(const Builder &builder, LveUploadBatch &uploadBatch);
         LveDevice &lveDevice;
+        BoundingBox boundingBox{};
+        glm::vec4 boundingSphere{0.f};
+
+        LveMeshPool *meshPool = nullptr;
+        LveMeshPool::Range meshRange{};
         
         std::unique_ptr<LveBuffer> vertexBuffer;
         uint32_t vertexCount;
@@ -0,0 +1,169 @@
+#include "lve_object_buffer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+LveObjectBuffer::LveObjectBuffer(LveDevice &device, uint32_t frameCount, uint32_t capacity)
+    : lveDevice{device}, frameCount{frameCount}, capacity{std::max(capacity, 1u)} {
+  setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                  .addBinding(
+                      0,
+                      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+                      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT |
+                          VK_SHADER_STAGE_COMPUTE_BIT)
+                  .addBinding(
+                      1,
+                      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+                      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT)
+                  .build();
+  // a set per growth can still be waiting for its frames to finish, older ones are freed
+  descriptorPool = LveDescriptorPool::Builder(lveDevice)
+                       .setMaxSets(MAX_GROWTHS + 1)
+                       .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 2 * (MAX_GROWTHS + 1))
+                       .build();
+  createBuffer();
+}
+
+LveObjectBuffer::~LveObjectBuffer() {}
+
+void LveObjectBuffer::createBuffer() {
+  if (buffer) {
+    recreateCount++;
+  }
+  buffer = std::make_unique<LveBuffer>(
+      lveDevice,
+      capacity * sizeof(ObjectData),
+      frameCount,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+      lveDevice.properties.limits.minStorageBufferOffsetAlignment);
+  buffer->map();
+  frameStride = buffer->getAlignmentSize();
+
+  // written by the cull pass on the gpu only
+  instanceBuffer = std::make_unique<LveBuffer>(
+      lveDevice,
+      INSTANCE_PASSES * capacity * sizeof(uint32_t),
+      frameCount,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      lveDevice.properties.limits.minStorageBufferOffsetAlignment);
+  instanceStride = instanceBuffer->getAlignmentSize();
+
+  auto bufferInfo = buffer->descriptorInfo(getFrameSize(), 0);
+  auto instanceInfo = instanceBuffer->descriptorInfo(getInstanceFrameSize(), 0);
+  if (!LveDescriptorWriter(*setLayout, *descriptorPool)
+           .writeBuffer(0, &bufferInfo)
+           .writeBuffer(1, &instanceInfo)
+           .build(descriptorSet)) {
+    throw std::runtime_error("failed to allocate object buffer descriptor set!");
+  }
+}
+
+void LveObjectBuffer::setFrameCount(uint32_t count) {
+  if (count == frameCount) {
+    return;
+  }
+  // nothing is in flight, the old buffer and set can go right away
+  std::vector<VkDescriptorSet> oldSets{descriptorSet};
+  descriptorPool->freeDescriptors(oldSets);
+  buffer.reset();
+  instanceBuffer.reset();
+  frameCount = count;
+  currentFrame = 0;
+  objectCount = 0;
+  instanceCount = 0;
+  createBuffer();
+}
+
+void LveObjectBuffer::beginFrame(int frameIndex, uint32_t objectCount) {
+  assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+  if (objectCount > capacity) {
+    if (growthCount == MAX_GROWTHS) {
+      throw std::runtime_error("object buffer grew too many times!");
+    }
+    growthCount++;
+    // frames in flight still read the old buffer through the old set, both go once those finish
+    std::shared_ptr<LveBuffer> oldBuffer = std::move(buffer);
+    std::shared_ptr<LveBuffer> oldInstances = std::move(instanceBuffer);
+    std::shared_ptr<LveDescriptorPool> pool = descriptorPool;
+    VkDescriptorSet oldSet = descriptorSet;
+    lveDevice.deletionQueue().push([oldBuffer, oldInstances, pool, oldSet]() {
+      std::vector<VkDescriptorSet> oldSets{oldSet};
+      pool->freeDescriptors(oldSets);
+    });
+    capacity = std::max(objectCount, capacity * 2);
+    createBuffer();
+  }
+  currentFrame = frameIndex;
+  this->objectCount = 0;
+  instanceCount = 0;
+}
+
+uint32_t LveObjectBuffer::write(const ObjectData &object) {
+  assert(objectCount < capacity && "Object buffer overflow, pass the object count to beginFrame");
+  char *frameData = static_cast<char *>(buffer->getMappedMemory()) + getFrameOffset(currentFrame);
+  memcpy(frameData + objectCount * sizeof(ObjectData), &object, sizeof(ObjectData));
+  return objectCount++;
+}
+
+uint32_t LveObjectBuffer::allocate(uint32_t count) {
+  assert(objectCount + count <= capacity && "Object buffer overflow, pass the object count to beginFrame");
+  uint32_t first = objectCount;
+  objectCount += count;
+  return first;
+}
+
+void LveObjectBuffer::write(uint32_t index, const ObjectData &object) {
+  assert(index < objectCount && "Object index was not allocated");
+  char *frameData = static_cast<char *>(buffer->getMappedMemory()) + getFrameOffset(currentFrame);
+  memcpy(frameData + index * sizeof(ObjectData), &object, sizeof(ObjectData));
+}
+
+uint32_t LveObjectBuffer::allocateInstances(uint32_t count) {
+  assert(
+      instanceCount + count <= INSTANCE_PASSES * capacity &&
+      "Instance table overflow, at most INSTANCE_PASSES entries per object");
+  uint32_t first = instanceCount;
+  instanceCount += count;
+  return first;
+}
+
+ObjectData *LveObjectBuffer::getFrameObjects() {
+  char *frameData = static_cast<char *>(buffer->getMappedMemory()) + getFrameOffset(currentFrame);
+  return reinterpret_cast<ObjectData *>(frameData);
+}
+
+void LveObjectBuffer::flush() {
+  if (objectCount > 0) {
+    buffer->flush(objectCount * sizeof(ObjectData), getFrameOffset(currentFrame));
+  }
+}
+
+void LveObjectBuffer::bind(
+    VkCommandBuffer commandBuffer,
+    VkPipelineLayout pipelineLayout,
+    uint32_t set,
+    VkPipelineBindPoint bindPoint) const {
+  uint32_t dynamicOffsets[] = {
+      static_cast<uint32_t>(getFrameOffset(currentFrame)),
+      static_cast<uint32_t>(getInstanceFrameOffset(currentFrame))};
+  vkCmdBindDescriptorSets(
+      commandBuffer,
+      bindPoint,
+      pipelineLayout,
+      set,
+      1,
+      &descriptorSet,
+      2,
+      dynamicOffsets);
+}
+
+}  // namespace lve
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+
+namespace lve {
+
+// mirrors ObjectData in the shaders (std430), new fields go before the padding
+struct ObjectData {
+  static constexpr uint32_t NO_DRAW = ~0u;
+
+  glm::mat4 modelMatrix{1.f};
+  glm::mat4 normalMatrix{1.f};
+  // the model's local bounding sphere (center, radius in w), read by the culling pass
+  glm::vec4 boundingSphere{0.f};
+  uint32_t materialIndex{0};
+  // entry in GpuCullSystem's draw table, NO_DRAW for objects the cpu draws itself
+  uint32_t drawIndex{NO_DRAW};
+  // the object's slot in GpuCullSystem's visibility from the last frame, stable across frames
+  uint32_t visibilityIndex{0};
+  uint32_t padding{};
+};
+static_assert(sizeof(ObjectData) % 16 == 0, "ObjectData must keep the std430 array stride");
+
+/*
+ * Per-object data for every draw of a frame, in one persistently mapped storage buffer.
+ *
+ * Each frame in flight owns a region of the buffer and the shaders index it with
+ * gl_InstanceIndex, so the data written here feeds single, instanced and indirect draws alike
+ * (firstInstance selects the object). Regions are selected with a dynamic offset, so a single
+ * descriptor set serves every frame. Writes go straight to mapped memory, either appended with
+ * write() or into a range reserved up front with allocate() when several threads record draws.
+ *
+ * Draws whose instances are picked on the gpu (see GpuCullSystem) go through the instance table
+ * at binding 1 instead: every instance holds the index of its object, and firstInstance selects
+ * the first entry. It has INSTANCE_PASSES entries per object of capacity, one range per cull pass.
+ */
+class LveObjectBuffer {
+ public:
+  static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+  // capacity doubles on every growth, the set of each growth is freed once its frames are done
+  static constexpr uint32_t MAX_GROWTHS = 16;
+  // instance table entries per object, the early and the late occlusion pass each fill a range
+  static constexpr uint32_t INSTANCE_PASSES = 2;
+
+  LveObjectBuffer(LveDevice &device, uint32_t frameCount, uint32_t capacity = DEFAULT_CAPACITY);
+  ~LveObjectBuffer();
+
+  LveObjectBuffer(const LveObjectBuffer &) = delete;
+  LveObjectBuffer &operator=(const LveObjectBuffer &) = delete;
+
+  // reallocates with one region per frame, only while no frame is in flight
+  void setFrameCount(uint32_t count);
+  // rewinds the frame's region and instance table, grows the buffers first if objectCount does not
+  // fit
+  void beginFrame(int frameIndex, uint32_t objectCount);
+  // returns the index to pass as firstInstance
+  uint32_t write(const ObjectData &object);
+  // reserves count consecutive objects and returns the first index. The reserved slots can then be
+  // filled from several threads with write(index, object)
+  uint32_t allocate(uint32_t count);
+  void write(uint32_t index, const ObjectData &object);
+  // reserves count consecutive entries of the instance table and returns the first one, for a
+  // compute pass to fill
+  uint32_t allocateInstances(uint32_t count);
+  // the current frame's region in mapped memory, for writers that fill allocated slots in place.
+  // Regions keep their contents across frames until the buffer grows
+  ObjectData *getFrameObjects();
+  void flush();
+
+  void bind(
+      VkCommandBuffer commandBuffer,
+      VkPipelineLayout pipelineLayout,
+      uint32_t set,
+      VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+  VkDescriptorSetLayout getDescriptorSetLayout() const {
+    return setLayout->getDescriptorSetLayout();
+  }
+  VkBuffer getBuffer() const { return buffer->getBuffer(); }
+  VkDeviceSize getFrameOffset(int frameIndex) const { return frameIndex * frameStride; }
+  VkDeviceSize getFrameSize() const { return capacity * sizeof(ObjectData); }
+  VkDeviceSize getInstanceFrameOffset(int frameIndex) const { return frameIndex * instanceStride; }
+  VkDeviceSize getInstanceFrameSize() const { return INSTANCE_PASSES * capacity * sizeof(uint32_t); }
+  uint32_t getFrameCount() const { return frameCount; }
+  // the frame of the last beginFrame
+  int getFrameIndex() const { return currentFrame; }
+  uint32_t getObjectCount() const { return objectCount; }
+  uint32_t getCapacity() const { return capacity; }
+  // bumped whenever the buffer is recreated, the regions lose their contents then
+  uint32_t getRecreateCount() const { return recreateCount; }
+
+ private:
+  void createBuffer();
+
+  LveDevice &lveDevice;
+  uint32_t frameCount;
+  uint32_t capacity;
+  VkDeviceSize frameStride = 0;
+  VkDeviceSize instanceStride = 0;
+
+  std::unique_ptr<LveBuffer> buffer;
+  std::unique_ptr<LveBuffer> instanceBuffer;
+  std::unique_ptr<LveDescriptorSetLayout> setLayout;
+  // shared with the deleters that free the sets replaced by a growth
+  std::shared_ptr<LveDescriptorPool> descriptorPool;
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+  int currentFrame = 0;
+  uint32_t objectCount = 0;
+  uint32_t instanceCount = 0;
+  uint32_t recreateCount = 0;
+  uint32_t growthCount = 0;
+};
+
+}  // namespace lve
@@ -0,0 +1,240 @@
+#include "lve_offscreen_target.hpp"
+
+#include "lve_buffer.hpp"
+#include "lve_png.hpp"
+#include "lve_swap_chain.hpp"
+
+// std
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+LveOffscreenTarget::LveOffscreenTarget(
+    LveDevice &deviceRef, VkExtent2D extent, const LveRendererSettings &settings)
+    : device{deviceRef}, extent{extent}, settings{settings} {
+  // the format a swap chain would prefer, with a fallback every implementation renders to
+  colorFormat = device.findSupportedFormat(
+      {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM},
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+  depthFormat = LveSwapChain::findDepthFormat(device);
+  renderPass = LveSwapChain::createRenderPass(
+      device,
+      colorFormat,
+      depthFormat,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+  resumeRenderPass = LveSwapChain::createRenderPass(
+      device,
+      colorFormat,
+      depthFormat,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      true);
+
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+  for (uint32_t i = 0; i < settings.framesInFlight; i++) {
+    colorAttachments.push_back(createAttachment(
+        colorFormat,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT));
+    depthAttachments.push_back(createAttachment(
+        depthFormat,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT));
+
+    std::array<VkImageView, 2> attachments = {colorAttachments[i].view, depthAttachments[i].view};
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create offscreen framebuffer!");
+    }
+    framebuffers.push_back(framebuffer);
+
+    VkFence fence;
+    if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create offscreen frame fence!");
+    }
+    inFlightFences.push_back(fence);
+  }
+}
+
+LveOffscreenTarget::~LveOffscreenTarget() {
+  for (auto fence : inFlightFences) {
+    vkDestroyFence(device.device(), fence, nullptr);
+  }
+  for (auto framebuffer : framebuffers) {
+    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+  }
+  for (auto &attachment : colorAttachments) {
+    destroyAttachment(attachment);
+  }
+  for (auto &attachment : depthAttachments) {
+    destroyAttachment(attachment);
+  }
+  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  vkDestroyRenderPass(device.device(), resumeRenderPass, nullptr);
+}
+
+LveOffscreenTarget::Attachment LveOffscreenTarget::createAttachment(
+    VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect) {
+  Attachment attachment{};
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = extent.width;
+  imageInfo.extent.height = extent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = format;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = usage;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  device.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      attachment.image,
+      attachment.memory);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = attachment.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = format;
+  viewInfo.subresourceRange.aspectMask = aspect;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(device.device(), &viewInfo, nullptr, &attachment.view) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create offscreen image view!");
+  }
+  return attachment;
+}
+
+void LveOffscreenTarget::destroyAttachment(Attachment &attachment) {
+  vkDestroyImageView(device.device(), attachment.view, nullptr);
+  vkDestroyImage(device.device(), attachment.image, nullptr);
+  device.allocator().free(attachment.memory);
+}
+
+void LveOffscreenTarget::waitForFrameFence() {
+  vkWaitForFences(
+      device.device(),
+      1,
+      &inFlightFences[currentFrame],
+      VK_TRUE,
+      std::numeric_limits<uint64_t>::max());
+}
+
+VkResult LveOffscreenTarget::acquireNextImage(uint32_t *imageIndex) {
+  waitForFrameFence();
+  *imageIndex = static_cast<uint32_t>(currentFrame);
+  return VK_SUCCESS;
+}
+
+VkResult LveOffscreenTarget::submitCommandBuffers(
+    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = buffers;
+
+  vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to submit draw command buffer!");
+  }
+
+  lastSubmitted = static_cast<int>(*imageIndex);
+  currentFrame = (currentFrame + 1) % settings.framesInFlight;
+  return VK_SUCCESS;
+}
+
+bool LveOffscreenTarget::saveImage(const std::string &filePath) {
+  if (lastSubmitted < 0) {
+    return false;
+  }
+  vkWaitForFences(
+      device.device(),
+      1,
+      &inFlightFences[lastSubmitted],
+      VK_TRUE,
+      std::numeric_limits<uint64_t>::max());
+
+  uint32_t pixelCount = extent.width * extent.height;
+  LveBuffer readback{
+      device,
+      4,
+      pixelCount,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+
+  VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+  // the render pass left the image in TRANSFER_SRC_OPTIMAL, this only orders the copy after it
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = colorAttachments[lastSubmitted].image;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent = {extent.width, extent.height, 1};
+  vkCmdCopyImageToBuffer(
+      commandBuffer,
+      colorAttachments[lastSubmitted].image,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      readback.getBuffer(),
+      1,
+      &region);
+
+  device.endSingleTimeCommands(commandBuffer);
+
+  readback.map();
+  readback.invalidate();
+  std::vector<uint8_t> pixels(pixelCount * 4);
+  const uint8_t *source = static_cast<const uint8_t *>(readback.getMappedMemory());
+  bool bgra = colorFormat == VK_FORMAT_B8G8R8A8_SRGB;
+  for (uint32_t i = 0; i < pixelCount; i++) {
+    pixels[i * 4 + 0] = source[i * 4 + (bgra ? 2 : 0)];
+    pixels[i * 4 + 1] = source[i * 4 + 1];
+    pixels[i * 4 + 2] = source[i * 4 + (bgra ? 0 : 2)];
+    pixels[i * 4 + 3] = source[i * 4 + 3];
+  }
+  return writePng(filePath, extent.width, extent.height, pixels.data());
+}
+
+}  // namespace lve
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_render_target.hpp"
+#include "lve_renderer_settings.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Offscreen color and depth images in place of a swap chain, for headless runs.
+ *
+ * There is one image pair per frame in flight and "acquiring" just waits for that frame's fence,
+ * so the frame loop and the render pass are the same as with a window. The color attachment ends
+ * in TRANSFER_SRC_OPTIMAL so finished frames can be copied out with saveImage().
+ */
+class LveOffscreenTarget : public LveRenderTarget {
+ public:
+  LveOffscreenTarget(LveDevice &device, VkExtent2D extent, const LveRendererSettings &settings);
+  ~LveOffscreenTarget() override;
+
+  LveOffscreenTarget(const LveOffscreenTarget &) = delete;
+  LveOffscreenTarget &operator=(const LveOffscreenTarget &) = delete;
+
+  VkRenderPass getRenderPass() override { return renderPass; }
+  VkRenderPass getResumeRenderPass() override { return resumeRenderPass; }
+  VkFramebuffer getFrameBuffer(int index) override { return framebuffers[index]; }
+  VkImageView getDepthImageView(int index) override { return depthAttachments[index].view; }
+  VkExtent2D getSwapChainExtent() override { return extent; }
+  uint32_t framesInFlight() const override { return settings.framesInFlight; }
+  // nothing is presented, frames go out as fast as the GPU finishes them
+  VkPresentModeKHR getPresentMode() const override { return VK_PRESENT_MODE_IMMEDIATE_KHR; }
+  VkFormat getColorFormat() const { return colorFormat; }
+
+  void waitForFrameFence() override;
+  VkResult acquireNextImage(uint32_t *imageIndex) override;
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) override;
+
+  // waits for the most recently submitted frame and writes it as PNG, returns false if nothing
+  // was rendered yet or the file could not be written. Stalls the queue, not for timed runs
+  bool saveImage(const std::string &filePath);
+
+ private:
+  struct Attachment {
+    VkImage image = VK_NULL_HANDLE;
+    LveAllocation memory{};
+    VkImageView view = VK_NULL_HANDLE;
+  };
+
+  Attachment createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+  void destroyAttachment(Attachment &attachment);
+
+  LveDevice &device;
+  VkExtent2D extent;
+  LveRendererSettings settings;
+  VkFormat colorFormat;
+  VkFormat depthFormat;
+
+  VkRenderPass renderPass = VK_NULL_HANDLE;
+  VkRenderPass resumeRenderPass = VK_NULL_HANDLE;
+  std::vector<Attachment> colorAttachments;
+  std::vector<Attachment> depthAttachments;
+  std::vector<VkFramebuffer> framebuffers;
+  std::vector<VkFence> inFlightFences;
+
+  size_t currentFrame = 0;
+  int lastSubmitted = -1;
+};
+
+}  // namespace lve
@@ -26,6 +26,8 @@ namespace lve
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // constant_id values of the vertex shader, must outlive the LvePipeline constructor
+        const VkSpecializationInfo* vertexSpecializationInfo = nullptr;
     };
 
     class LvePipeline
@@ -40,9 +42,10 @@ namespace lve
 
         void bind(VkCommandBuffer commandBuffer);
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        // reads a whole binary file, also used for the compute shaders of LveComputePipeline
+        static std::vector<char> readFile(const std::string &filepath);
 
     private:
-        static std::vector<char> readFile(const std::string &filepath);
         void createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
         void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
 
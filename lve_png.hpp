@@ -0,0 +1,13 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+// writes 8 bit RGBA pixels, rows top to bottom. The image data is stored uncompressed (deflate
+// stored blocks), which keeps the writer dependency free at the cost of file size
+bool writePng(const std::string &filePath, uint32_t width, uint32_t height, const uint8_t *rgba);
+
+}  // namespace lve
@@ -0,0 +1,144 @@
+#include "lve_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+struct ZoneEvent {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+// written by its thread only, head is published with release so a reader sees complete events
+struct ThreadBuffer {
+  uint32_t threadId = 0;
+  std::atomic<const char *> threadName{nullptr};
+  std::atomic<uint64_t> head{0};
+  std::array<ZoneEvent, LveProfiler::RING_SIZE> events;
+};
+
+struct Registry {
+  std::mutex mutex;
+  // buffers are never freed, a thread that exits keeps its zones in the trace
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+ThreadBuffer &threadBuffer() {
+  // the registry lock is only taken the first time a thread records
+  thread_local ThreadBuffer *buffer = [] {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock{reg.mutex};
+    reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+    reg.buffers.back()->threadId = static_cast<uint32_t>(reg.buffers.size());
+    return reg.buffers.back().get();
+  }();
+  return *buffer;
+}
+
+void writeEscaped(std::ofstream &out, const char *text) {
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\') {
+      out << '\\';
+    }
+    out << *text;
+  }
+}
+
+}  // namespace
+
+void LveProfiler::record(const char *name, uint64_t startNs, uint64_t endNs) {
+  ThreadBuffer &buffer = threadBuffer();
+  uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  // the last head store becomes visible no later than the overwrite below, pairs with the acquire
+  // fence in writeChromeTrace
+  std::atomic_thread_fence(std::memory_order_release);
+  buffer.events[head % RING_SIZE] = {name, startNs, endNs};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void LveProfiler::setThreadName(const char *name) {
+  threadBuffer().threadName.store(name, std::memory_order_relaxed);
+}
+
+bool LveProfiler::writeChromeTrace(const std::string &filePath) {
+  std::ofstream out{filePath};
+  if (!out) {
+    return false;
+  }
+
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lock{reg.mutex};
+
+  uint64_t origin = UINT64_MAX;
+  std::vector<std::vector<ZoneEvent>> snapshots;
+  for (auto &buffer : reg.buffers) {
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+    std::vector<ZoneEvent> events;
+    events.reserve(static_cast<size_t>(head - first));
+    for (uint64_t i = first; i < head; i++) {
+      events.push_back(buffer->events[i % RING_SIZE]);
+    }
+    // the owning thread kept recording, drop whatever it may have overwritten meanwhile. A store
+    // into slot newHead % RING_SIZE may be under way, so the event it replaces is dropped as well.
+    // The fence keeps the copies above from being reordered after the second head load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t newHead = buffer->head.load(std::memory_order_relaxed);
+    uint64_t overwritten = newHead + 1 > RING_SIZE ? newHead + 1 - RING_SIZE : 0;
+    if (overwritten > first) {
+      events.erase(
+          events.begin(),
+          events.begin() + static_cast<size_t>(std::min(overwritten - first, head - first)));
+    }
+    for (auto &event : events) {
+      origin = std::min(origin, event.start);
+    }
+    snapshots.push_back(std::move(events));
+  }
+
+  out << "{\"traceEvents\":[\n";
+  bool firstEvent = true;
+  char timing[96];
+  for (size_t t = 0; t < reg.buffers.size(); t++) {
+    uint32_t tid = reg.buffers[t]->threadId;
+    if (const char *threadName = reg.buffers[t]->threadName.load(std::memory_order_relaxed)) {
+      out << (firstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << tid << ",\"args\":{\"name\":\"";
+      writeEscaped(out, threadName);
+      out << "\"}}";
+      firstEvent = false;
+    }
+    for (auto &event : snapshots[t]) {
+      out << (firstEvent ? "" : ",\n") << "{\"name\":\"";
+      writeEscaped(out, event.name);
+      // chrome traces are in microseconds
+      snprintf(
+          timing,
+          sizeof(timing),
+          "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+          (event.start - origin) / 1000.0,
+          (event.end - event.start) / 1000.0);
+      out << timing << ",\"pid\":1,\"tid\":" << tid << "}";
+      firstEvent = false;
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+}  // namespace lve
@@ -0,0 +1,65 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+/*
+ * CPU scoped-zone profiler with Chrome trace export.
+ *
+ * Every thread writes its zones into its own fixed size ring, so recording takes no lock: a zone
+ * is two clock reads and one store of {name, start, end}. writeChromeTrace() copies whatever the
+ * rings currently hold (the last RING_SIZE zones per thread) into a chrome://tracing / Perfetto
+ * JSON file. Zone names must outlive the profiler, string literals are expected.
+ *
+ * Use the LVE_PROFILE_* macros, they compile to nothing unless LVE_PROFILER_ENABLED is set
+ * (cmake option LVE_ENABLE_PROFILER).
+ */
+class LveProfiler {
+ public:
+  static constexpr uint32_t RING_SIZE = 1 << 16;
+
+  static uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+  }
+
+  static void record(const char *name, uint64_t startNs, uint64_t endNs);
+  // shows up as the thread's name in the trace
+  static void setThreadName(const char *name);
+  static bool writeChromeTrace(const std::string &filePath);
+};
+
+class LveProfileZone {
+ public:
+  explicit LveProfileZone(const char *name) : name{name}, start{LveProfiler::now()} {}
+  ~LveProfileZone() { LveProfiler::record(name, start, LveProfiler::now()); }
+
+  LveProfileZone(const LveProfileZone &) = delete;
+  LveProfileZone &operator=(const LveProfileZone &) = delete;
+
+ private:
+  const char *name;
+  uint64_t start;
+};
+
+}  // namespace lve
+
+#define LVE_PROFILE_CONCAT_INNER(a, b) a##b
+#define LVE_PROFILE_CONCAT(a, b) LVE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef LVE_PROFILER_ENABLED
+#define LVE_PROFILE_SCOPE(name) \
+  ::lve::LveProfileZone LVE_PROFILE_CONCAT(lveProfileZone, __LINE__) { name }
+#define LVE_PROFILE_FUNCTION() LVE_PROFILE_SCOPE(__func__)
+#define LVE_PROFILE_THREAD(name) ::lve::LveProfiler::setThreadName(name)
+#else
+#define LVE_PROFILE_SCOPE(name)
+#define LVE_PROFILE_FUNCTION()
+#define LVE_PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace lve {
+
+/*
+ * What LveRenderer draws into: a swap chain for a window or offscreen images.
+ *
+ * Both share the same render pass layout (one color and one depth attachment, one subpass), so
+ * pipelines and render systems work with either one. Depth is stored and left readable, so compute
+ * passes can build on it (see LveDepthPyramid).
+ */
+class LveRenderTarget {
+ public:
+  virtual ~LveRenderTarget() = default;
+
+  virtual VkRenderPass getRenderPass() = 0;
+  // compatible with getRenderPass() but loads color and depth, continues a frame after compute
+  // work that had to run between two parts of its draws
+  virtual VkRenderPass getResumeRenderPass() = 0;
+  virtual VkFramebuffer getFrameBuffer(int index) = 0;
+  // the depth attachment of getFrameBuffer(index), in DEPTH_STENCIL_READ_ONLY_OPTIMAL after the
+  // render pass so it can be sampled
+  virtual VkImageView getDepthImageView(int index) = 0;
+  virtual VkExtent2D getSwapChainExtent() = 0;
+  virtual uint32_t framesInFlight() const = 0;
+  virtual VkPresentModeKHR getPresentMode() const = 0;
+
+  float extentAspectRatio() {
+    VkExtent2D extent = getSwapChainExtent();
+    return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+  }
+
+  // blocks until the GPU is done with the current frame's resources
+  virtual void waitForFrameFence() = 0;
+  virtual VkResult acquireNextImage(uint32_t *imageIndex) = 0;
+  virtual VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) = 0;
+};
+
+}  // namespace lve
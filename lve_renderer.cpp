@@ -1,73 +1,105 @@
 #include "lve_renderer.hpp"
+#include "lve_profiler.hpp"
 
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 
 namespace lve {
 
-LveRenderer::LveRenderer(LveWindow &window, LveDevice &device) : lveWindow{window}, lveDevice{device} {
-    recreateSwapChain();
-    createCommandBuffers();
+static float millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+LveRenderer::LveRenderer(LveWindow &window, LveDevice &device, const LveRendererSettings &settings) : lveWindow{&window}, lveDevice{device} {
+    applySettings(settings);
+}
+
+LveRenderer::LveRenderer(LveDevice &device, VkExtent2D extent, const LveRendererSettings &settings) : lveDevice{device}, headlessExtent{extent} {
+    applySettings(settings);
 }
 
 LveRenderer::~LveRenderer() {
-    freeCommandBuffers();
+    vkDeviceWaitIdle(lveDevice.device());
+    lveDevice.deletionQueue().flushAll();
+    commandAllocator.reset();
+}
+
+void LveRenderer::applySettings(const LveRendererSettings &newSettings) {
+    assert(!isFrameStarted && "Can't change renderer settings while a frame is in progress");
+    LveRendererSettings clamped = newSettings;
+    clamped.framesInFlight = std::clamp<uint32_t>(clamped.framesInFlight, 1, LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+    bool swapChainChanged = renderTarget == nullptr ||
+                            clamped.framesInFlight != settings.framesInFlight ||
+                            clamped.presentMode != settings.presentMode;
+    settings = clamped;
+    // pacing settings are read by the frame loop, only the swap chain ones need a new swap chain
+    if (!swapChainChanged) {
+        return;
+    }
+
+    recreateSwapChain();
+    // the device is idle after recreateSwapChain
+    if (commandAllocator == nullptr) {
+        commandAllocator = std::make_unique<LveCommandAllocator>(lveDevice, settings.framesInFlight);
+    } else {
+        commandAllocator->setFrameCount(settings.framesInFlight);
+    }
 }
 
 void LveRenderer::recreateSwapChain() {
-    auto extent = lveWindow.getExtend();
+    if (lveWindow == nullptr) {
+        vkDeviceWaitIdle(lveDevice.device());
+        lveDevice.deletionQueue().flushAll();
+        lveDevice.deletionQueue().setFramesInFlight(settings.framesInFlight);
+        currentFrameIndex = 0;
+        // offscreen images never go out of date, this only runs when the settings change
+        offscreenTarget.reset();
+        offscreenTarget = std::make_unique<LveOffscreenTarget>(lveDevice, headlessExtent, settings);
+        renderTarget = offscreenTarget.get();
+        return;
+    }
+
+    auto extent = lveWindow->getExtend();
     while (extent.width == 0 || extent.height == 0) {
-        extent = lveWindow.getExtend();
+        extent = lveWindow->getExtend();
         glfwWaitEvents();
     }
     vkDeviceWaitIdle(lveDevice.device());
+    lveDevice.deletionQueue().flushAll();
+    lveDevice.deletionQueue().setFramesInFlight(settings.framesInFlight);
+    // a new swap chain starts at frame 0 with fresh fences
+    currentFrameIndex = 0;
 
     if (lveSwapChain == nullptr) {
-        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, settings);
     } else {
         std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, settings, oldSwapChain);
         if(!oldSwapChain->compareSwapFormats(*lveSwapChain.get())){
             throw std::runtime_error("Swap chain image (or depth) format has changed");
         }
     }
+    renderTarget = lveSwapChain.get();
 }
 
-void LveRenderer::createCommandBuffers() {
-    // resize command buffer count to have one for each image in swap chain
-    //.imageCount() returns the number of images in the swap chain
-    // imageCount will likely be 2 or 3 depends on my device supports double or triple buffering
-    // apple silicone m1 and m2 supports triple buffering
-
-    // each command buffer is going to draw to a different frame buffer here
-    commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    // there are 2 types command buffers: primary and secondary
-    // primary can be submitted to a queue for execution, but cannot be called from other command buffers
-    // secondary cannot be submitted directly, but can be called from other command buffers
-    // with vkCmdExecuteCommands command from primary command buffer secondary command buffers can be called by other command buffers
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = lveDevice.getCommandPool();
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers");
-    }
+void LveRenderer::waitForFrameFence() {
+    LVE_PROFILE_SCOPE("wait for frame fence");
+    assert(!isFrameStarted && "Can't wait for the next frame while a frame is in progress");
+    auto start = std::chrono::steady_clock::now();
+    renderTarget->waitForFrameFence();
+    frameWaits.fenceMs = millisecondsSince(start);
 }
 
-void LveRenderer::freeCommandBuffers() {
-    vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-    commandBuffers.clear();
-}
-
-
 VkCommandBuffer LveRenderer::beginFrame() {
+    LVE_PROFILE_SCOPE("beginFrame");
     assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
-    auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+    auto acquireStart = std::chrono::steady_clock::now();
+    auto result = renderTarget->acquireNextImage(&currentImageIndex);
+    frameWaits.acquireMs = millisecondsSince(acquireStart);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
@@ -77,10 +109,20 @@ VkCommandBuffer LveRenderer::beginFrame() {
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swap chain image");
     }
+    // the fence for this frame slot has been waited on, older frames are done with their resources
+    lveDevice.deletionQueue().beginFrame(frameNumber);
     isFrameStarted = true;
-    auto commandBuffer = getCurrentCommandBuffer();
+
+    // there are 2 types command buffers: primary and secondary
+    // primary can be submitted to a queue for execution, but cannot be called from other command buffers
+    // secondary cannot be submitted directly, but can be called from other command buffers
+    // with vkCmdExecuteCommands command from primary command buffer secondary command buffers can be called by other command buffers
+    commandAllocator->beginFrame(currentFrameIndex);
+    currentCommandBuffer = commandAllocator->allocate(0, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    auto commandBuffer = currentCommandBuffer;
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to being recording command buffer");
@@ -88,34 +130,61 @@ VkCommandBuffer LveRenderer::beginFrame() {
     return commandBuffer;
 }
 void LveRenderer::endFrame() {
+    LVE_PROFILE_SCOPE("endFrame");
     assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
     auto commandBuffer = getCurrentCommandBuffer();
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer");
     }
 
-    auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
-        lveWindow.resetWindowResizeFlag();
+    auto presentStart = std::chrono::steady_clock::now();
+    auto result = renderTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+    frameWaits.presentMs = millisecondsSince(presentStart);
+    lastFrameWaits = frameWaits;
+    frameWaits = {};
+    isFrameStarted = false;
+    currentFrameIndex = (currentFrameIndex+1) % settings.framesInFlight;
+    frameNumber++;
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (lveWindow && lveWindow->wasWindowResized())) {
+        if (lveWindow) lveWindow->resetWindowResizeFlag();
         recreateSwapChain();
     }
 
     else if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image");
     }
-    isFrameStarted = false;
-    currentFrameIndex = (currentFrameIndex+1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
 }
-void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+VkCommandBufferInheritanceInfo LveRenderer::getRenderPassInheritance() const {
+    assert(isFrameStarted && "Cannot get the render pass inheritance when frame not in progress");
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderTarget->getRenderPass();
+    inheritance.subpass = 0;
+    inheritance.framebuffer = renderTarget->getFrameBuffer(currentImageIndex);
+    return inheritance;
+}
+
+void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
+    beginRenderPass(commandBuffer, renderTarget->getRenderPass(), contents);
+}
 
+void LveRenderer::resumeSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+    assert(isFrameStarted && "Can't call resumeSwapChainRenderPass if frame is not in progress");
+    assert(commandBuffer == getCurrentCommandBuffer() && "Can't resume render pass on command buffer from a different frame");
+    // loads both attachments, the clear values below are ignored
+    beginRenderPass(commandBuffer, renderTarget->getResumeRenderPass(), contents);
+}
+
+void LveRenderer::beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents) {
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = lveSwapChain->getRenderPass();
-    renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = renderTarget->getFrameBuffer(currentImageIndex);
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+    renderPassInfo.renderArea.extent = renderTarget->getSwapChainExtent();
 
     std::array<VkClearValue, 2> clearValues{};
     // in the render pass attachments are structured with index
@@ -127,7 +196,7 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
     /*
     --inline:
@@ -149,15 +218,19 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
 
     You can't mix these to ways.
     */
+    if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+        // dynamic state is not inherited, every secondary sets it for itself
+        return;
+    }
 
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height);
+    viewport.width = static_cast<float>(renderTarget->getSwapChainExtent().width);
+    viewport.height = static_cast<float>(renderTarget->getSwapChainExtent().height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    VkRect2D scissor{{0, 0}, lveSwapChain->getSwapChainExtent()};
+    VkRect2D scissor{{0, 0}, renderTarget->getSwapChainExtent()};
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "lve_command_allocator.hpp"
 #include "lve_device.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_renderer_settings.hpp"
 #include "lve_swap_chain.hpp"
 #include "lve_window.hpp"
 
@@ -13,44 +16,90 @@ namespace lve {
 
     class LveRenderer {
         public:
-        LveRenderer(LveWindow& window, LveDevice& device);
+        // cpu time blocked in the last frame's fence wait, image acquire and submit + present
+        struct FrameWaits {
+            float fenceMs = 0.f;
+            float acquireMs = 0.f;
+            float presentMs = 0.f;
+        };
+
+        LveRenderer(LveWindow& window, LveDevice& device, const LveRendererSettings& settings = LveRendererSettings{});
+        // headless, renders into offscreen images of the given size, needs a headless LveDevice
+        LveRenderer(LveDevice& device, VkExtent2D extent, const LveRendererSettings& settings = LveRendererSettings{});
         ~LveRenderer();
         LveRenderer(const LveRenderer&) = delete;
         LveRenderer& operator=(const LveRenderer&) = delete;
 
-        VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass();}
-        float getAspectRatio ()const {return lveSwapChain->extentAspectRatio();}
+        VkRenderPass getSwapChainRenderPass() const { return renderTarget->getRenderPass();}
+        float getAspectRatio ()const {return renderTarget->extentAspectRatio();}
+        VkExtent2D getSwapChainExtent() const {return renderTarget->getSwapChainExtent();}
+        // for secondary command buffers that continue the current frame's render pass
+        VkCommandBufferInheritanceInfo getRenderPassInheritance() const;
+        bool isHeadless() const {return lveWindow == nullptr;}
+        // null unless headless
+        LveOffscreenTarget* getOffscreenTarget() const {return offscreenTarget.get();}
         bool isFrameInProgress() const {return isFrameStarted;}
 
+        // recreates the swap chain right away, call it between frames
+        void applySettings(const LveRendererSettings& newSettings);
+        const LveRendererSettings& getSettings() const {return settings;}
+        uint32_t getFramesInFlight() const {return settings.framesInFlight;}
+        VkPresentModeKHR getPresentMode() const {return renderTarget->getPresentMode();}
+
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted&&"Cannot get command buffer when frame not in progress");
-            return commandBuffers[currentFrameIndex];
+            return currentCommandBuffer;
             }
 
+        // waits for the fence of the frame beginFrame will start
+        void waitForFrameFence();
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the primary only executes secondaries,
+        // which set their own viewport and scissor (see LveSecondaryRecorder)
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // begins the render pass again after it was ended mid frame, keeping color and depth.
+        // Secondaries recorded with getRenderPassInheritance() stay compatible
+        void resumeSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        // this frame's depth attachment, readable by shaders once the render pass has ended
+        VkImageView getDepthImageView() const {
+            assert(isFrameStarted&&"Cannot get depth image view when frame not in progress");
+            return renderTarget->getDepthImageView(currentImageIndex);
+        }
 
         int getFrameIndex() const {
             assert(isFrameStarted&&"Cannot get frame index when frame not in progress");
             return currentFrameIndex;
         }
+        // the frame beginFrame starts next, or the one in progress
+        int getFrameSlot() const { return currentFrameIndex; }
+        const FrameWaits& getLastFrameWaits() const { return lastFrameWaits; }
         
     private:
 
-        void createCommandBuffers();
-        void freeCommandBuffers();
         void recreateSwapChain();
+        void beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents);
 
-        LveWindow& lveWindow;
+        LveWindow* lveWindow = nullptr;
         LveDevice& lveDevice;
+        LveRendererSettings settings;
+        VkExtent2D headlessExtent{};
         std::unique_ptr<LveSwapChain> lveSwapChain;
-        std::vector<VkCommandBuffer> commandBuffers;
+        std::unique_ptr<LveOffscreenTarget> offscreenTarget;
+        // whichever of the two is in use
+        LveRenderTarget* renderTarget = nullptr;
+        // one pool per frame in flight, reset once per frame instead of per command buffer
+        std::unique_ptr<LveCommandAllocator> commandAllocator;
+        VkCommandBuffer currentCommandBuffer = VK_NULL_HANDLE;
 
         uint32_t currentImageIndex;
-        int currentFrameIndex;
+        // must match the swap chain's frame so per frame resources are guarded by the right fence
+        int currentFrameIndex = 0;
+        uint64_t frameNumber = 0;
         bool isFrameStarted = false; // not sure about that. Check that later
+        FrameWaits frameWaits{};
+        FrameWaits lastFrameWaits{};
     
     };
 }
\ No newline at end of file
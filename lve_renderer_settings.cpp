@@ -0,0 +1,63 @@
+#include "lve_renderer_settings.hpp"
+
+// std
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace lve {
+
+LveRendererSettings LveRendererSettings::fromEnvironment() {
+  LveRendererSettings settings{};
+
+  if (const char *frames = std::getenv("LVE_FRAMES_IN_FLIGHT")) {
+    int count = std::atoi(frames);
+    if (count > 0) {
+      settings.framesInFlight = static_cast<uint32_t>(count);
+    } else {
+      std::cerr << "ignoring LVE_FRAMES_IN_FLIGHT=" << frames << std::endl;
+    }
+  }
+
+  if (const char *mode = std::getenv("LVE_PRESENT_MODE")) {
+    if (strcmp(mode, "fifo") == 0) {
+      settings.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    } else if (strcmp(mode, "fifo_relaxed") == 0) {
+      settings.presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    } else if (strcmp(mode, "mailbox") == 0) {
+      settings.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    } else if (strcmp(mode, "immediate") == 0) {
+      settings.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    } else {
+      std::cerr << "ignoring LVE_PRESENT_MODE=" << mode << std::endl;
+    }
+  }
+
+  if (const char *lowLatency = std::getenv("LVE_LOW_LATENCY")) {
+    settings.lowLatency = std::atoi(lowLatency) != 0;
+  }
+
+  if (const char *limit = std::getenv("LVE_FRAME_LIMIT")) {
+    settings.frameLimit = static_cast<float>(std::max(0.0, std::atof(limit)));
+  }
+
+  return settings;
+}
+
+const char *LveRendererSettings::presentModeName(VkPresentModeKHR presentMode) {
+  switch (presentMode) {
+    case VK_PRESENT_MODE_FIFO_KHR:
+      return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+      return "FIFO_RELAXED";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+      return "MAILBOX";
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+      return "IMMEDIATE";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+}  // namespace lve
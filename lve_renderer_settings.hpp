@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+
+namespace lve {
+
+/*
+ * Latency versus throughput knobs of the renderer.
+ *
+ * framesInFlight is clamped to [1, LveSwapChain::MAX_FRAMES_IN_FLIGHT]. A present mode the surface
+ * does not support falls back to FIFO, which every surface supports. Both can be changed while
+ * running through LveRenderer::applySettings, which recreates the swap chain.
+ */
+struct LveRendererSettings {
+  uint32_t framesInFlight = 2;
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+  // wait for the frame's fence before sampling input instead of after
+  bool lowLatency = false;
+  // frames per second, 0 is unlimited
+  float frameLimit = 0.f;
+
+  // LVE_FRAMES_IN_FLIGHT=1..4, LVE_PRESENT_MODE=fifo|fifo_relaxed|mailbox|immediate,
+  // LVE_LOW_LATENCY=0|1 and LVE_FRAME_LIMIT=fps override the defaults, so deployments can be
+  // tuned without recompiling
+  static LveRendererSettings fromEnvironment();
+  static const char *presentModeName(VkPresentModeKHR presentMode);
+};
+
+}  // namespace lve
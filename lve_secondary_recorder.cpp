@@ -0,0 +1,70 @@
+#include "lve_secondary_recorder.hpp"
+
+#include "lve_profiler.hpp"
+
+// std
+#include <stdexcept>
+
+namespace lve {
+
+LveSecondaryRecorder::LveSecondaryRecorder(
+    LveDevice &device, LveWorkerPool &workerPool, uint32_t frameCount)
+    : workerPool{workerPool}, commandAllocator{device, frameCount, workerPool.getThreadCount()} {}
+
+LveSecondaryRecorder::~LveSecondaryRecorder() {}
+
+void LveSecondaryRecorder::beginFrame(
+    int frameIndex, const VkCommandBufferInheritanceInfo &inheritance, VkExtent2D extent) {
+  this->inheritance = inheritance;
+  this->inheritance.pNext = nullptr;
+  this->extent = extent;
+  recorded.clear();
+  commandAllocator.beginFrame(frameIndex);
+}
+
+VkCommandBuffer LveSecondaryRecorder::beginSecondary(uint32_t threadIndex) {
+  VkCommandBuffer commandBuffer =
+      commandAllocator.allocate(threadIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = &inheritance;
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin secondary command buffer!");
+  }
+
+  VkViewport viewport{};
+  viewport.width = static_cast<float>(extent.width);
+  viewport.height = static_cast<float>(extent.height);
+  viewport.maxDepth = 1.0f;
+  VkRect2D scissor{{0, 0}, extent};
+  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+  return commandBuffer;
+}
+
+void LveSecondaryRecorder::record(uint32_t jobCount, const RecordFunction &recordFunction) {
+  size_t first = recorded.size();
+  recorded.resize(first + jobCount, VK_NULL_HANDLE);
+  workerPool.run(jobCount, [&](uint32_t jobIndex, uint32_t threadIndex) {
+    LVE_PROFILE_SCOPE("record secondary");
+    VkCommandBuffer commandBuffer = beginSecondary(threadIndex);
+    recordFunction(commandBuffer, jobIndex);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to record secondary command buffer!");
+    }
+    recorded[first + jobIndex] = commandBuffer;
+  });
+}
+
+void LveSecondaryRecorder::execute(VkCommandBuffer primaryCommandBuffer) {
+  if (!recorded.empty()) {
+    vkCmdExecuteCommands(
+        primaryCommandBuffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+  }
+  recorded.clear();
+}
+
+}  // namespace lve
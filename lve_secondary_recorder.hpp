@@ -0,0 +1,59 @@
+#pragma once
+
+#include "lve_command_allocator.hpp"
+#include "lve_device.hpp"
+#include "lve_worker_pool.hpp"
+
+// std
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Records the contents of a render pass into secondary command buffers on several threads.
+ *
+ * Buffers come from an LveCommandAllocator with a pool per frame in flight and thread, so threads
+ * never share a pool and the frame's pools are reset as a whole. Each secondary inherits the
+ * render pass and starts with the viewport and scissor set, everything else (pipeline, descriptor
+ * sets, vertex buffers) has to be bound again since no state is inherited from the primary.
+ *
+ * The render pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and
+ * everything recorded through record() is executed in order by execute().
+ */
+class LveSecondaryRecorder {
+ public:
+  using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t jobIndex)>;
+
+  LveSecondaryRecorder(LveDevice &device, LveWorkerPool &workerPool, uint32_t frameCount);
+  ~LveSecondaryRecorder();
+
+  LveSecondaryRecorder(const LveSecondaryRecorder &) = delete;
+  LveSecondaryRecorder &operator=(const LveSecondaryRecorder &) = delete;
+
+  // recreates the pools, only while no frame is in flight
+  void setFrameCount(uint32_t count) { commandAllocator.setFrameCount(count); }
+
+  // resets the frame's pools, its fence must have been waited on. Call after the render pass was
+  // begun, with the inheritance info of that render pass
+  void beginFrame(
+      int frameIndex, const VkCommandBufferInheritanceInfo &inheritance, VkExtent2D extent);
+  // records jobCount secondaries in parallel, one per job. A single job runs on the calling thread
+  void record(uint32_t jobCount, const RecordFunction &recordFunction);
+  // executes everything recorded since beginFrame in recording order
+  void execute(VkCommandBuffer primaryCommandBuffer);
+
+  uint32_t getThreadCount() const { return workerPool.getThreadCount(); }
+  LveWorkerPool &getWorkerPool() const { return workerPool; }
+
+ private:
+  VkCommandBuffer beginSecondary(uint32_t threadIndex);
+
+  LveWorkerPool &workerPool;
+  LveCommandAllocator commandAllocator;
+  VkCommandBufferInheritanceInfo inheritance{};
+  VkExtent2D extent{};
+  std::vector<VkCommandBuffer> recorded;
+};
+
+}  // namespace lve
@@ -0,0 +1,67 @@
+#include "lve_simd.hpp"
+
+#if defined(LVE_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace lve {
+
+namespace {
+
+#ifdef LVE_SIMD_X86
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  bool fma = (info[2] & (1 << 12)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  // the OS has to save the ymm registers
+  if (!fma || !osxsave || (_xgetbv(0) & 6) != 6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif  // LVE_SIMD_X86
+
+}  // namespace
+
+LveSimdPath bestSimdPath() {
+#ifdef LVE_SIMD_X86
+  static const LveSimdPath path = cpuHasAvx2() ? LveSimdPath::Avx2 : LveSimdPath::Sse;
+  return path;
+#else
+  return LveSimdPath::Scalar;
+#endif
+}
+
+bool isSimdPathSupported(LveSimdPath path) {
+  switch (path) {
+    case LveSimdPath::Scalar:
+      return true;
+#ifdef LVE_SIMD_X86
+    case LveSimdPath::Sse:
+      return true;
+    case LveSimdPath::Avx2:
+      return bestSimdPath() == LveSimdPath::Avx2;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char *simdPathName(LveSimdPath path) {
+  switch (path) {
+    case LveSimdPath::Avx2:
+      return "avx2";
+    case LveSimdPath::Sse:
+      return "sse";
+    default:
+      return "scalar";
+  }
+}
+
+}  // namespace lve
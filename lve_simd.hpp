@@ -0,0 +1,27 @@
+#pragma once
+
+// the simd paths are only built for x86-64, where SSE2 is always there
+#if defined(__x86_64__) || defined(_M_X64)
+#define LVE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// compiles a single function for AVX2 without raising the requirements of the whole build
+#if defined(LVE_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LVE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define LVE_TARGET_AVX2
+#endif
+
+namespace lve {
+
+// the instruction sets the cpu side batch kernels (culling, transforms) are written for
+enum class LveSimdPath { Scalar, Sse, Avx2 };
+
+// the fastest path this CPU runs: AVX2 with FMA when the CPU and OS support it, SSE on every other
+// x86-64 CPU and scalar code everywhere else
+LveSimdPath bestSimdPath();
+bool isSimdPathSupported(LveSimdPath path);
+const char *simdPathName(LveSimdPath path);
+
+}  // namespace lve
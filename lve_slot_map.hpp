@@ -0,0 +1,156 @@
+#pragma once
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+// a view of count consecutive elements, what std::span is in C++20
+template <typename T>
+class LveSpan {
+ public:
+  LveSpan() = default;
+  LveSpan(T *first, size_t count) : first{first}, count{count} {}
+
+  T *begin() const { return first; }
+  T *end() const { return first + count; }
+  T *data() const { return first; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  T &operator[](size_t index) const {
+    assert(index < count && "Span index out of range");
+    return first[index];
+  }
+
+ private:
+  T *first = nullptr;
+  size_t count = 0;
+};
+
+// refers to an element of an LveSlotMap, stays valid until the element is erased
+struct LveSlotHandle {
+  static constexpr uint32_t INVALID_INDEX = ~0u;
+
+  uint32_t index{INVALID_INDEX};
+  uint32_t generation{0};
+
+  bool operator==(const LveSlotHandle &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const LveSlotHandle &other) const { return !(*this == other); }
+};
+
+/*
+ * Elements in one contiguous array, addressed through stable generational handles.
+ *
+ * Insert and erase are O(1): a handle picks a slot, the slot holds the element's position in the
+ * dense array. Erasing moves the last element into the hole (swap and pop), so iteration always
+ * walks size() consecutive elements with no holes, in no particular order. A slot's generation is
+ * bumped when its element is erased, handles to the old element then no longer resolve. Pointers
+ * and references into the dense array are invalidated by insert and erase, handles are not.
+ */
+template <typename T>
+class LveSlotMap {
+ public:
+  LveSlotHandle insert(T &&value) {
+    uint32_t slotIndex;
+    if (freeHead != LveSlotHandle::INVALID_INDEX) {
+      slotIndex = freeHead;
+      freeHead = slots[slotIndex].denseIndex;
+    } else {
+      slotIndex = static_cast<uint32_t>(slots.size());
+      slots.push_back({});
+    }
+    Slot &slot = slots[slotIndex];
+    slot.denseIndex = static_cast<uint32_t>(values.size());
+    values.push_back(std::move(value));
+    denseToSlot.push_back(slotIndex);
+    return {slotIndex, slot.generation};
+  }
+
+  // returns false for a handle that no longer resolves
+  bool erase(LveSlotHandle handle) {
+    if (!contains(handle)) return false;
+    Slot &slot = slots[handle.index];
+    const uint32_t denseIndex = slot.denseIndex;
+    const uint32_t last = static_cast<uint32_t>(values.size()) - 1;
+    if (denseIndex != last) {
+      values[denseIndex] = std::move(values[last]);
+      denseToSlot[denseIndex] = denseToSlot[last];
+      slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+    }
+    values.pop_back();
+    denseToSlot.pop_back();
+
+    slot.generation++;
+    slot.denseIndex = freeHead;
+    freeHead = handle.index;
+    return true;
+  }
+
+  bool contains(LveSlotHandle handle) const {
+    return handle.index < slots.size() && slots[handle.index].generation == handle.generation &&
+           slots[handle.index].denseIndex < values.size() &&
+           denseToSlot[slots[handle.index].denseIndex] == handle.index;
+  }
+
+  // nullptr for a handle that no longer resolves
+  T *get(LveSlotHandle handle) {
+    return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+  }
+  const T *get(LveSlotHandle handle) const {
+    return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+  }
+  // the handle of the element at a position of the dense array
+  LveSlotHandle handleAt(size_t denseIndex) const {
+    const uint32_t slotIndex = denseToSlot[denseIndex];
+    return {slotIndex, slots[slotIndex].generation};
+  }
+
+  // outstanding handles stay invalid, the slots are reused with their generations kept
+  void clear() {
+    for (size_t i = 0; i < values.size(); i++) {
+      LveSlotHandle handle = handleAt(i);
+      slots[handle.index].generation++;
+      slots[handle.index].denseIndex = freeHead;
+      freeHead = handle.index;
+    }
+    values.clear();
+    denseToSlot.clear();
+  }
+
+  void reserve(size_t count) {
+    values.reserve(count);
+    denseToSlot.reserve(count);
+    slots.reserve(count);
+  }
+
+  size_t size() const { return values.size(); }
+  bool empty() const { return values.empty(); }
+  T *data() { return values.data(); }
+  typename std::vector<T>::iterator begin() { return values.begin(); }
+  typename std::vector<T>::iterator end() { return values.end(); }
+  typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+  typename std::vector<T>::const_iterator end() const { return values.end(); }
+  LveSpan<T> span() { return {values.data(), values.size()}; }
+  LveSpan<const T> span() const { return {values.data(), values.size()}; }
+
+ private:
+  struct Slot {
+    // the element's position in values, the next free slot while the slot is free
+    uint32_t denseIndex{LveSlotHandle::INVALID_INDEX};
+    uint32_t generation{0};
+  };
+
+  std::vector<T> values;
+  // the slot of each element, to fix up the slot of the element moved by erase
+  std::vector<uint32_t> denseToSlot;
+  std::vector<Slot> slots;
+  uint32_t freeHead = LveSlotHandle::INVALID_INDEX;
+};
+
+}  // namespace lve
@@ -0,0 +1,171 @@
+#include "lve_staging_ring.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+LveStagingRing::LveStagingRing(LveDevice &device, VkDeviceSize capacity)
+    : lveDevice{device}, capacity{capacity} {
+  ringBuffer = std::make_unique<LveBuffer>(
+      lveDevice,
+      capacity,
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  ringBuffer->map();
+}
+
+LveStagingRing::~LveStagingRing() {
+  for (auto &[serial, region] : regions) {
+    if (region.closed && !region.complete) {
+      vkWaitForFences(
+          lveDevice.device(), 1, &region.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+      vkDestroyFence(lveDevice.device(), region.fence, nullptr);
+    }
+  }
+  for (auto fence : freeFences) {
+    vkDestroyFence(lveDevice.device(), fence, nullptr);
+  }
+}
+
+uint64_t LveStagingRing::openRegion() {
+  uint64_t serial = nextSerial++;
+  regions.emplace(serial, Region{});
+  return serial;
+}
+
+/**
+ * Reserves size bytes of contiguous staging memory for an open region
+ *
+ * @param alignment Required alignment of the returned offset, must be a power of two
+ * @param allocation Receives the buffer, offset and mapped pointer of the reservation
+ *
+ * @return false if the reservation cannot be made without submitting an open region first
+ */
+bool LveStagingRing::allocate(
+    uint64_t region, VkDeviceSize size, VkDeviceSize alignment, Allocation &allocation) {
+  assert(
+      regions.count(region) != 0 && !regions.at(region).closed &&
+      "Staging allocations go to an open region");
+  if (size > capacity) {
+    return false;
+  }
+
+  while (true) {
+    if (usedBytes == 0) {
+      head = 0;
+    }
+
+    VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+    if (offset + size > capacity) {
+      // the tail end of the ring is too short, skip it and start again at 0
+      offset = 0;
+    }
+    VkDeviceSize consumed = (offset >= head ? offset - head : capacity - head + offset) + size;
+
+    if (consumed <= capacity - usedBytes) {
+      head = offset + size;
+      usedBytes += consumed;
+      totalAllocatedBytes += size;
+      peakUsedBytes = std::max(peakUsedBytes, usedBytes);
+      if (!spans.empty() && spans.back().region == region) {
+        spans.back().bytes += consumed;
+      } else {
+        spans.push_back({region, consumed});
+        regions.at(region).spanCount++;
+      }
+
+      allocation.buffer = ringBuffer->getBuffer();
+      allocation.offset = offset;
+      allocation.mapped = static_cast<char *>(ringBuffer->getMappedMemory()) + offset;
+      return true;
+    }
+
+    reclaim();
+    if (consumed <= capacity - usedBytes) {
+      continue;
+    }
+    // the oldest bytes must be freed first, whoever staged them
+    const Region &oldest = regions.at(spans.front().region);
+    if (!oldest.closed) {
+      // not submitted yet, waiting would never end
+      return false;
+    }
+    blockingWaitCount++;
+    pollRegion(spans.front().region, true);
+    retireSpans();
+  }
+}
+
+VkFence LveStagingRing::closeRegion(uint64_t serial) {
+  Region &region = regions.at(serial);
+  assert(!region.closed && "Staging region closed twice");
+  if (freeFences.empty()) {
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &region.fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create staging ring fence!");
+    }
+  } else {
+    region.fence = freeFences.back();
+    freeFences.pop_back();
+  }
+  region.closed = true;
+  return region.fence;
+}
+
+void LveStagingRing::wait(uint64_t serial) {
+  assert((regions.count(serial) == 0 || regions.at(serial).closed) && "Waiting on an open region");
+  pollRegion(serial, true);
+  retireSpans();
+}
+
+void LveStagingRing::reclaim() { retireSpans(); }
+
+bool LveStagingRing::pollRegion(uint64_t serial, bool block) {
+  auto found = regions.find(serial);
+  if (found == regions.end()) {
+    // released already
+    return true;
+  }
+  Region &region = found->second;
+  if (region.complete) {
+    return true;
+  }
+  if (!region.closed) {
+    return false;
+  }
+  if (block) {
+    vkWaitForFences(
+        lveDevice.device(), 1, &region.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+  } else if (vkGetFenceStatus(lveDevice.device(), region.fence) != VK_SUCCESS) {
+    return false;
+  }
+  vkResetFences(lveDevice.device(), 1, &region.fence);
+  freeFences.push_back(region.fence);
+  region.fence = VK_NULL_HANDLE;
+  region.complete = true;
+  if (region.spanCount == 0) {
+    regions.erase(found);
+  }
+  return true;
+}
+
+void LveStagingRing::retireSpans() {
+  while (!spans.empty() && pollRegion(spans.front().region, false)) {
+    const Span span = spans.front();
+    spans.pop_front();
+    assert(usedBytes >= span.bytes && "Staging ring accounting out of sync");
+    usedBytes -= span.bytes;
+    auto region = regions.find(span.region);
+    if (--region->second.spanCount == 0) {
+      regions.erase(region);
+    }
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Long lived, persistently mapped staging buffer used as a ring.
+ *
+ * Uploads bump the head offset. Every allocation belongs to a region opened by its uploader, so
+ * uploaders staging at the same time never share a region. Closing a region hands out a fence
+ * that must be passed to the vkQueueSubmit which reads that region. Space is reclaimed in
+ * allocation order once the region owning the oldest bytes has completed, so the only blocking
+ * wait happens when the ring is full.
+ */
+class LveStagingRing {
+ public:
+  static constexpr VkDeviceSize DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+  struct Allocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    void *mapped = nullptr;
+  };
+
+  LveStagingRing(LveDevice &device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+  ~LveStagingRing();
+
+  LveStagingRing(const LveStagingRing &) = delete;
+  LveStagingRing &operator=(const LveStagingRing &) = delete;
+
+  // returns the serial identifying the region in allocate, closeRegion and wait
+  uint64_t openRegion();
+  // Returns false when the space is held by a region that is still open (close and submit it
+  // first) or when size is larger than the ring. Blocks on the oldest submitted region when the
+  // ring is full.
+  bool allocate(uint64_t region, VkDeviceSize size, VkDeviceSize alignment, Allocation &allocation);
+
+  // The returned fence must be signaled by the submit that consumes the region
+  VkFence closeRegion(uint64_t region);
+  // blocks until the closed region's submit has finished
+  void wait(uint64_t region);
+  void reclaim();
+
+  VkDeviceSize getCapacity() const { return capacity; }
+  VkDeviceSize getBytesInFlight() const { return usedBytes; }
+  VkDeviceSize getPeakBytesInFlight() const { return peakUsedBytes; }
+  VkDeviceSize getTotalAllocatedBytes() const { return totalAllocatedBytes; }
+  uint32_t getRegionsInFlight() const { return static_cast<uint32_t>(regions.size()); }
+  uint32_t getBlockingWaitCount() const { return blockingWaitCount; }
+
+ private:
+  struct Region {
+    VkFence fence = VK_NULL_HANDLE;
+    // spans of the ring still holding this region's bytes
+    uint32_t spanCount = 0;
+    bool closed = false;
+    bool complete = false;
+  };
+  // consecutive ring bytes of one region, kept in allocation order
+  struct Span {
+    uint64_t region;
+    VkDeviceSize bytes;
+  };
+
+  // true once the region's submit has finished, its fence is recycled then
+  bool pollRegion(uint64_t serial, bool block);
+  // frees the oldest spans whose regions have completed
+  void retireSpans();
+
+  LveDevice &lveDevice;
+  std::unique_ptr<LveBuffer> ringBuffer;
+  VkDeviceSize capacity;
+
+  VkDeviceSize head = 0;
+  VkDeviceSize usedBytes = 0;
+
+  std::deque<Span> spans;
+  // open and in flight regions by serial
+  std::unordered_map<uint64_t, Region> regions;
+  std::vector<VkFence> freeFences;
+  uint64_t nextSerial = 1;
+
+  VkDeviceSize peakUsedBytes = 0;
+  VkDeviceSize totalAllocatedBytes = 0;
+  uint32_t blockingWaitCount = 0;
+};
+
+}  // namespace lve
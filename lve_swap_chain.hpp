@@ -1,6 +1,8 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_render_target.hpp"
+#include "lve_renderer_settings.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -11,33 +13,50 @@
 
 namespace lve {
 
-class LveSwapChain {
+class LveSwapChain : public LveRenderTarget {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+  // upper bound for LveRendererSettings::framesInFlight, per frame containers can be sized by it
+  static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
 
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
-  ~LveSwapChain();
+  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, const LveRendererSettings &settings);
+  LveSwapChain(
+      LveDevice &deviceRef,
+      VkExtent2D windowExtent,
+      const LveRendererSettings &settings,
+      std::shared_ptr<LveSwapChain> previous);
+  ~LveSwapChain() override;
 
   LveSwapChain(const LveSwapChain &) = delete;
   LveSwapChain& operator=(const LveSwapChain &) = delete;
 
-  VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-  VkRenderPass getRenderPass() { return renderPass; }
+  VkFramebuffer getFrameBuffer(int index) override { return swapChainFramebuffers[index]; }
+  VkRenderPass getRenderPass() override { return renderPass; }
+  VkRenderPass getResumeRenderPass() override { return resumeRenderPass; }
+  VkImageView getDepthImageView(int index) override { return depthImageViews[index]; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
   size_t imageCount() { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
-  VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+  VkExtent2D getSwapChainExtent() override { return swapChainExtent; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
+  uint32_t framesInFlight() const override { return settings.framesInFlight; }
+  // may differ from the requested mode when the surface does not support it
+  VkPresentModeKHR getPresentMode() const override { return presentMode; }
 
-  float extentAspectRatio() {
-    return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
-  }
   VkFormat findDepthFormat();
-
-  VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  static VkFormat findDepthFormat(LveDevice &device);
+  // the render pass every render target uses, only the color attachment's final layout differs.
+  // With loadContents the attachments keep what an earlier pass of the frame left in them
+  static VkRenderPass createRenderPass(
+      LveDevice &device,
+      VkFormat colorFormat,
+      VkFormat depthFormat,
+      VkImageLayout colorFinalLayout,
+      bool loadContents = false);
+
+  void waitForFrameFence() override;
+  VkResult acquireNextImage(uint32_t *imageIndex) override;
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) override;
 
   bool compareSwapFormats(const LveSwapChain& swapChain) const {
     // if they both are the same render pass must be compatible
@@ -66,15 +85,18 @@ class LveSwapChain {
 
   std::vector<VkFramebuffer> swapChainFramebuffers;
   VkRenderPass renderPass;
+  VkRenderPass resumeRenderPass;
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<LveAllocation> depthImageMemorys;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
 
   LveDevice &device;
   VkExtent2D windowExtent;
+  LveRendererSettings settings;
+  VkPresentModeKHR presentMode;
 
   VkSwapchainKHR swapChain;
   std::shared_ptr<LveSwapChain> oldSwapChain;
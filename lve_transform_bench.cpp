@@ -0,0 +1,149 @@
+// Microbenchmark of LveTransformSystem: writes the model and normal matrices of a fixed random set
+// of transforms that all changed, with every path the CPU supports, on one thread and on a worker
+// pool, and prints the time per frame of each.
+//
+//   lve_transform_bench --transforms 1000000 --iterations 50 --threads 0
+
+#include "lve_transform_system.hpp"
+#include "lve_worker_pool.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // the cpu budget for a frame's worth of dynamic transforms
+    constexpr double TARGET_MILLISECONDS = 2.0;
+    constexpr uint32_t TARGET_TRANSFORMS = 1000000;
+
+    struct Options {
+        uint32_t transforms = TARGET_TRANSFORMS;
+        uint32_t iterations = 50;
+        // 0 uses every hardware thread
+        uint32_t threads = 0;
+    };
+
+    bool parseArgs(int argc, char *argv[], Options &options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--transforms") options.transforms = std::stoul(value());
+            else if (arg == "--iterations") options.iterations = std::stoul(value());
+            else if (arg == "--threads") options.threads = std::stoul(value());
+            else return false;
+        }
+        return options.transforms > 0 && options.iterations > 0;
+    }
+
+    // every transform is dirty in every iteration, the worst case of a fully dynamic scene
+    void measure(const std::string &name, const Options &options, lve::LveTransformSystem &transforms,
+                 std::vector<lve::ObjectData> &objects, lve::LveWorkerPool *workers, lve::LveSimdPath path) {
+        transforms.markAllDirty();
+        transforms.write(objects.data(), 0, workers, path);
+        double seconds = 0.0;
+        for (uint32_t i = 0; i < options.iterations; i++) {
+            transforms.markAllDirty();
+            auto start = std::chrono::steady_clock::now();
+            transforms.write(objects.data(), 0, workers, path);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        double milliseconds = seconds * 1e3 / options.iterations;
+        // the budget scales with the count so smaller runs stay comparable
+        double budget = TARGET_MILLISECONDS * options.transforms / TARGET_TRANSFORMS;
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << milliseconds << " ms/frame  "
+                  << std::setprecision(1) << std::setw(8) << options.transforms / seconds * options.iterations / 1e6
+                  << " M transforms/s"
+                  << (milliseconds > budget ? "  (over budget)" : "") << "\n";
+    }
+
+    float maxDifference(const std::vector<lve::ObjectData> &a, const std::vector<lve::ObjectData> &b) {
+        float difference = 0.f;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 4; row++) {
+                    difference = std::max(difference, std::abs(a[i].modelMatrix[column][row] - b[i].modelMatrix[column][row]));
+                    difference = std::max(difference, std::abs(a[i].normalMatrix[column][row] - b[i].normalMatrix[column][row]));
+                }
+            }
+        }
+        return difference;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    using namespace lve;
+    Options options{};
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            std::cout << "usage: lve_transform_bench [--transforms n] [--iterations n] [--threads n]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // a fixed seed, every run writes the same transforms
+    std::mt19937 random{1234};
+    std::uniform_real_distribution<float> position{-100.f, 100.f};
+    std::uniform_real_distribution<float> angle{-glm::two_pi<float>(), glm::two_pi<float>()};
+    std::uniform_real_distribution<float> size{0.25f, 2.f};
+    LveTransformSystem transforms{1};
+    transforms.reserve(options.transforms);
+    for (uint32_t i = 0; i < options.transforms; i++) {
+        transforms.add(
+            {position(random), position(random), position(random)},
+            {angle(random), angle(random), angle(random)},
+            {size(random), size(random), size(random)});
+    }
+    std::vector<ObjectData> objects(options.transforms);
+    std::vector<ObjectData> reference(options.transforms);
+    transforms.write(reference.data(), 0, nullptr, LveSimdPath::Scalar);
+
+    LveWorkerPool workers{options.threads};
+    std::cout << options.transforms << " transforms, " << options.iterations << " iterations, "
+              << workers.getThreadCount() << " threads, target " << TARGET_MILLISECONDS << " ms per "
+              << TARGET_TRANSFORMS << "\n";
+    bool mismatch = false;
+    for (auto path : {LveSimdPath::Scalar, LveSimdPath::Sse, LveSimdPath::Avx2}) {
+        if (!isSimdPathSupported(path)) continue;
+        measure(std::string{simdPathName(path)} + " 1 thread", options, transforms, objects, nullptr, path);
+        if (workers.getThreadCount() > 1) {
+            measure(std::string{simdPathName(path)} + " " + std::to_string(workers.getThreadCount()) + " threads",
+                    options, transforms, objects, &workers, path);
+        }
+        // the polynomial sine and cosine against the C library's
+        if (maxDifference(objects, reference) > 1e-3f) mismatch = true;
+    }
+
+    // nothing changed, only the dirty checks are left
+    auto start = std::chrono::steady_clock::now();
+    uint32_t written = transforms.write(objects.data(), 0, &workers);
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(20) << "static" << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << milliseconds << " ms/frame  " << written << " written\n";
+
+    if (mismatch) {
+        std::cerr << "the simd paths disagree with the scalar one" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
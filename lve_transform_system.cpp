@@ -0,0 +1,459 @@
+#include "lve_transform_system.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace lve {
+
+LveTransformSystem::LveTransformSystem(uint32_t frameCount) : frameCount{frameCount} {
+  assert(frameCount > 0 && frameCount <= MAX_FRAME_COUNT && "Frame count must fit the pending bits");
+}
+
+void LveTransformSystem::setFrameCount(uint32_t count) {
+  assert(count > 0 && count <= MAX_FRAME_COUNT && "Frame count must fit the pending bits");
+  frameCount = count;
+  markAllDirty();
+}
+
+void LveTransformSystem::clear() {
+  count = 0;
+  dirtyCount = 0;
+  pendingFrames.clear();
+  for (auto *component : {&translationX, &translationY, &translationZ, &rotationX, &rotationY,
+                          &rotationZ, &scaleX, &scaleY, &scaleZ}) {
+    component->clear();
+  }
+}
+
+void LveTransformSystem::truncate(uint32_t newCount) {
+  if (newCount >= count) {
+    return;
+  }
+  for (uint32_t i = newCount; i < count; i++) {
+    if (pendingFrames[i] != 0) dirtyCount--;
+  }
+  // the dropped lanes of the last batch become padding again, see add()
+  const uint32_t padded = (newCount + LANES - 1) / LANES * LANES;
+  for (auto *component : {&translationX, &translationY, &translationZ, &rotationX, &rotationY,
+                          &rotationZ}) {
+    component->resize(padded);
+    std::fill(component->begin() + newCount, component->end(), 0.f);
+  }
+  for (auto *component : {&scaleX, &scaleY, &scaleZ}) {
+    component->resize(padded);
+    std::fill(component->begin() + newCount, component->end(), 1.f);
+  }
+  pendingFrames.resize(padded);
+  std::fill(pendingFrames.begin() + newCount, pendingFrames.end(), uint8_t{0});
+  count = newCount;
+}
+
+void LveTransformSystem::reserve(uint32_t capacity) {
+  capacity = (capacity + LANES - 1) / LANES * LANES;
+  pendingFrames.reserve(capacity);
+  for (auto *component : {&translationX, &translationY, &translationZ, &rotationX, &rotationY,
+                          &rotationZ, &scaleX, &scaleY, &scaleZ}) {
+    component->reserve(capacity);
+  }
+}
+
+uint32_t LveTransformSystem::add(
+    const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale) {
+  if (count == paddedSize()) {
+    // the padding is computed along with its batch but never written out, unit scale keeps the
+    // inverse finite
+    for (auto *component : {&translationX, &translationY, &translationZ, &rotationX, &rotationY,
+                            &rotationZ}) {
+      component->resize(count + LANES, 0.f);
+    }
+    for (auto *component : {&scaleX, &scaleY, &scaleZ}) {
+      component->resize(count + LANES, 1.f);
+    }
+    pendingFrames.resize(count + LANES, 0);
+  }
+  set(count, translation, rotation, scale);
+  return count++;
+}
+
+void LveTransformSystem::set(
+    uint32_t index, const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale) {
+  assert(index < paddedSize() && "Transform index out of range");
+  translationX[index] = translation.x;
+  translationY[index] = translation.y;
+  translationZ[index] = translation.z;
+  rotationX[index] = rotation.x;
+  rotationY[index] = rotation.y;
+  rotationZ[index] = rotation.z;
+  scaleX[index] = scale.x;
+  scaleY[index] = scale.y;
+  scaleZ[index] = scale.z;
+  markDirty(index);
+}
+
+void LveTransformSystem::setTranslation(uint32_t index, const glm::vec3 &translation) {
+  assert(index < count && "Transform index out of range");
+  translationX[index] = translation.x;
+  translationY[index] = translation.y;
+  translationZ[index] = translation.z;
+  markDirty(index);
+}
+
+void LveTransformSystem::setRotation(uint32_t index, const glm::vec3 &rotation) {
+  assert(index < count && "Transform index out of range");
+  rotationX[index] = rotation.x;
+  rotationY[index] = rotation.y;
+  rotationZ[index] = rotation.z;
+  markDirty(index);
+}
+
+void LveTransformSystem::setScale(uint32_t index, const glm::vec3 &scale) {
+  assert(index < count && "Transform index out of range");
+  scaleX[index] = scale.x;
+  scaleY[index] = scale.y;
+  scaleZ[index] = scale.z;
+  markDirty(index);
+}
+
+glm::vec3 LveTransformSystem::getTranslation(uint32_t index) const {
+  return {translationX[index], translationY[index], translationZ[index]};
+}
+
+glm::vec3 LveTransformSystem::getRotation(uint32_t index) const {
+  return {rotationX[index], rotationY[index], rotationZ[index]};
+}
+
+glm::vec3 LveTransformSystem::getScale(uint32_t index) const {
+  return {scaleX[index], scaleY[index], scaleZ[index]};
+}
+
+void LveTransformSystem::markDirty(uint32_t index) {
+  if (pendingFrames[index] == 0) dirtyCount++;
+  pendingFrames[index] = static_cast<uint8_t>((1u << frameCount) - 1);
+}
+
+void LveTransformSystem::markAllDirty() {
+  std::fill(
+      pendingFrames.begin(), pendingFrames.begin() + count, static_cast<uint8_t>((1u << frameCount) - 1));
+  dirtyCount = count;
+}
+
+namespace {
+
+void writeScalar(const LveTransformSystem &transforms, uint32_t first, ObjectData *objects) {
+  for (uint32_t lane = 0; lane < LveTransformSystem::LANES; lane++) {
+    const uint32_t i = first + lane;
+    const float c3 = std::cos(transforms.rotationZ[i]);
+    const float s3 = std::sin(transforms.rotationZ[i]);
+    const float c2 = std::cos(transforms.rotationX[i]);
+    const float s2 = std::sin(transforms.rotationX[i]);
+    const float c1 = std::cos(transforms.rotationY[i]);
+    const float s1 = std::sin(transforms.rotationY[i]);
+    const glm::vec3 axisX{c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1};
+    const glm::vec3 axisY{c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3};
+    const glm::vec3 axisZ{c2 * s1, -s2, c1 * c2};
+    const glm::vec3 scale{transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]};
+    ObjectData &object = objects[lane];
+    object.modelMatrix[0] = glm::vec4{scale.x * axisX, 0.f};
+    object.modelMatrix[1] = glm::vec4{scale.y * axisY, 0.f};
+    object.modelMatrix[2] = glm::vec4{scale.z * axisZ, 0.f};
+    object.modelMatrix[3] =
+        glm::vec4{transforms.translationX[i], transforms.translationY[i], transforms.translationZ[i], 1.f};
+    object.normalMatrix[0] = glm::vec4{axisX / scale.x, 0.f};
+    object.normalMatrix[1] = glm::vec4{axisY / scale.y, 0.f};
+    object.normalMatrix[2] = glm::vec4{axisZ / scale.z, 0.f};
+    object.normalMatrix[3] = glm::vec4{0.f, 0.f, 0.f, 1.f};
+  }
+}
+
+#ifdef LVE_SIMD_X86
+
+// Cephes' sinf/cosf: reduction to [-pi/4, pi/4] by octant in three steps for the extra precision,
+// then the sine and cosine polynomials, swapped and negated by octant
+constexpr float FOUR_OVER_PI = 1.27323954473516f;
+constexpr float REDUCE_1 = 0.78515625f;
+constexpr float REDUCE_2 = 2.4187564849853515625e-4f;
+constexpr float REDUCE_3 = 3.77489497744594108e-8f;
+constexpr float COS_0 = 2.443315711809948e-5f;
+constexpr float COS_1 = -1.388731625493765e-3f;
+constexpr float COS_2 = 4.166664568298827e-2f;
+constexpr float SIN_0 = -1.9515295891e-4f;
+constexpr float SIN_1 = 8.3321608736e-3f;
+constexpr float SIN_2 = -1.6666654611e-1f;
+
+void sinCosSse(__m128 x, __m128 &sine, __m128 &cosine) {
+  const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+  __m128 sineSign = _mm_and_ps(x, signMask);
+  x = _mm_andnot_ps(signMask, x);
+
+  __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+  octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+  const __m128 y = _mm_cvtepi32_ps(octant);
+  sineSign = _mm_xor_ps(sineSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+  const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+      _mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+  const __m128 usePolynomial = _mm_castsi128_ps(
+      _mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(REDUCE_1)));
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(REDUCE_2)));
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(REDUCE_3)));
+  const __m128 z = _mm_mul_ps(x, x);
+
+  __m128 cosinePolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_0), z), _mm_set1_ps(COS_1));
+  cosinePolynomial = _mm_add_ps(_mm_mul_ps(cosinePolynomial, z), _mm_set1_ps(COS_2));
+  cosinePolynomial = _mm_mul_ps(_mm_mul_ps(cosinePolynomial, z), z);
+  cosinePolynomial = _mm_sub_ps(cosinePolynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  cosinePolynomial = _mm_add_ps(cosinePolynomial, _mm_set1_ps(1.f));
+
+  __m128 sinePolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_0), z), _mm_set1_ps(SIN_1));
+  sinePolynomial = _mm_add_ps(_mm_mul_ps(sinePolynomial, z), _mm_set1_ps(SIN_2));
+  sinePolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinePolynomial, z), x), x);
+
+  sine = _mm_or_ps(_mm_and_ps(usePolynomial, sinePolynomial), _mm_andnot_ps(usePolynomial, cosinePolynomial));
+  cosine = _mm_or_ps(_mm_and_ps(usePolynomial, cosinePolynomial), _mm_andnot_ps(usePolynomial, sinePolynomial));
+  sine = _mm_xor_ps(sine, sineSign);
+  cosine = _mm_xor_ps(cosine, cosineSign);
+}
+
+// columns 0-3 are the model matrix, 4-7 the normal matrix
+inline float *column(ObjectData &object, int index) {
+  return index < 4 ? &object.modelMatrix[index][0] : &object.normalMatrix[index - 4][0];
+}
+
+// four objects' column of a matrix from its components, one register per component
+inline void storeColumnSse(__m128 x, __m128 y, __m128 z, __m128 w, ObjectData *objects, int index) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(column(objects[0], index), x);
+  _mm_storeu_ps(column(objects[1], index), y);
+  _mm_storeu_ps(column(objects[2], index), z);
+  _mm_storeu_ps(column(objects[3], index), w);
+}
+
+void writeSse(const LveTransformSystem &transforms, uint32_t first, ObjectData *objects) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.f);
+  for (uint32_t half = 0; half < LveTransformSystem::LANES; half += 4) {
+    const uint32_t i = first + half;
+    __m128 s1, c1, s2, c2, s3, c3;
+    sinCosSse(_mm_loadu_ps(&transforms.rotationY[i]), s1, c1);
+    sinCosSse(_mm_loadu_ps(&transforms.rotationX[i]), s2, c2);
+    sinCosSse(_mm_loadu_ps(&transforms.rotationZ[i]), s3, c3);
+    const __m128 s2s3 = _mm_mul_ps(s2, s3);
+    const __m128 s2c3 = _mm_mul_ps(s2, c3);
+    const __m128 axisXx = _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1, s2s3));
+    const __m128 axisXy = _mm_mul_ps(c2, s3);
+    const __m128 axisXz = _mm_sub_ps(_mm_mul_ps(c1, s2s3), _mm_mul_ps(c3, s1));
+    const __m128 axisYx = _mm_sub_ps(_mm_mul_ps(s1, s2c3), _mm_mul_ps(c1, s3));
+    const __m128 axisYy = _mm_mul_ps(c2, c3);
+    const __m128 axisYz = _mm_add_ps(_mm_mul_ps(c1, s2c3), _mm_mul_ps(s1, s3));
+    const __m128 axisZx = _mm_mul_ps(c2, s1);
+    const __m128 axisZy = _mm_sub_ps(zero, s2);
+    const __m128 axisZz = _mm_mul_ps(c1, c2);
+
+    const __m128 sx = _mm_loadu_ps(&transforms.scaleX[i]);
+    const __m128 sy = _mm_loadu_ps(&transforms.scaleY[i]);
+    const __m128 sz = _mm_loadu_ps(&transforms.scaleZ[i]);
+    ObjectData *out = objects + half;
+    storeColumnSse(_mm_mul_ps(sx, axisXx), _mm_mul_ps(sx, axisXy), _mm_mul_ps(sx, axisXz), zero, out, 0);
+    storeColumnSse(_mm_mul_ps(sy, axisYx), _mm_mul_ps(sy, axisYy), _mm_mul_ps(sy, axisYz), zero, out, 1);
+    storeColumnSse(_mm_mul_ps(sz, axisZx), _mm_mul_ps(sz, axisZy), _mm_mul_ps(sz, axisZz), zero, out, 2);
+    storeColumnSse(
+        _mm_loadu_ps(&transforms.translationX[i]),
+        _mm_loadu_ps(&transforms.translationY[i]),
+        _mm_loadu_ps(&transforms.translationZ[i]),
+        one, out, 3);
+
+    const __m128 isx = _mm_div_ps(one, sx);
+    const __m128 isy = _mm_div_ps(one, sy);
+    const __m128 isz = _mm_div_ps(one, sz);
+    storeColumnSse(_mm_mul_ps(isx, axisXx), _mm_mul_ps(isx, axisXy), _mm_mul_ps(isx, axisXz), zero, out, 4);
+    storeColumnSse(_mm_mul_ps(isy, axisYx), _mm_mul_ps(isy, axisYy), _mm_mul_ps(isy, axisYz), zero, out, 5);
+    storeColumnSse(_mm_mul_ps(isz, axisZx), _mm_mul_ps(isz, axisZy), _mm_mul_ps(isz, axisZz), zero, out, 6);
+    storeColumnSse(zero, zero, zero, one, out, 7);
+  }
+}
+
+LVE_TARGET_AVX2 void sinCosAvx2(__m256 x, __m256 &sine, __m256 &cosine) {
+  const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000u)));
+  __m256 sineSign = _mm256_and_ps(x, signMask);
+  x = _mm256_andnot_ps(signMask, x);
+
+  __m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+  octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+  const __m256 y = _mm256_cvtepi32_ps(octant);
+  sineSign = _mm256_xor_ps(
+      sineSign, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29)));
+  const __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+  const __m256 usePolynomial = _mm256_castsi256_ps(
+      _mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+  x = _mm256_fnmadd_ps(y, _mm256_set1_ps(REDUCE_1), x);
+  x = _mm256_fnmadd_ps(y, _mm256_set1_ps(REDUCE_2), x);
+  x = _mm256_fnmadd_ps(y, _mm256_set1_ps(REDUCE_3), x);
+  const __m256 z = _mm256_mul_ps(x, x);
+
+  __m256 cosinePolynomial = _mm256_fmadd_ps(_mm256_set1_ps(COS_0), z, _mm256_set1_ps(COS_1));
+  cosinePolynomial = _mm256_fmadd_ps(cosinePolynomial, z, _mm256_set1_ps(COS_2));
+  cosinePolynomial = _mm256_mul_ps(_mm256_mul_ps(cosinePolynomial, z), z);
+  cosinePolynomial = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cosinePolynomial);
+  cosinePolynomial = _mm256_add_ps(cosinePolynomial, _mm256_set1_ps(1.f));
+
+  __m256 sinePolynomial = _mm256_fmadd_ps(_mm256_set1_ps(SIN_0), z, _mm256_set1_ps(SIN_1));
+  sinePolynomial = _mm256_fmadd_ps(sinePolynomial, z, _mm256_set1_ps(SIN_2));
+  sinePolynomial = _mm256_fmadd_ps(_mm256_mul_ps(sinePolynomial, z), x, x);
+
+  sine = _mm256_blendv_ps(cosinePolynomial, sinePolynomial, usePolynomial);
+  cosine = _mm256_blendv_ps(sinePolynomial, cosinePolynomial, usePolynomial);
+  sine = _mm256_xor_ps(sine, sineSign);
+  cosine = _mm256_xor_ps(cosine, cosineSign);
+}
+
+// eight objects' column of a matrix, the 128 bit halves of each transposed register are the
+// columns of lanes i and i + 4
+LVE_TARGET_AVX2 inline void storeColumnAvx2(__m256 x, __m256 y, __m256 z, __m256 w, ObjectData *objects, int index) {
+  const __m256 xyLow = _mm256_unpacklo_ps(x, y);
+  const __m256 xyHigh = _mm256_unpackhi_ps(x, y);
+  const __m256 zwLow = _mm256_unpacklo_ps(z, w);
+  const __m256 zwHigh = _mm256_unpackhi_ps(z, w);
+  const __m256 rows[] = {
+      _mm256_shuffle_ps(xyLow, zwLow, 0x44),
+      _mm256_shuffle_ps(xyLow, zwLow, 0xee),
+      _mm256_shuffle_ps(xyHigh, zwHigh, 0x44),
+      _mm256_shuffle_ps(xyHigh, zwHigh, 0xee)};
+  for (int lane = 0; lane < 4; lane++) {
+    _mm_storeu_ps(column(objects[lane], index), _mm256_castps256_ps128(rows[lane]));
+    _mm_storeu_ps(column(objects[lane + 4], index), _mm256_extractf128_ps(rows[lane], 1));
+  }
+}
+
+LVE_TARGET_AVX2 void writeAvx2(const LveTransformSystem &transforms, uint32_t i, ObjectData *objects) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.f);
+  __m256 s1, c1, s2, c2, s3, c3;
+  sinCosAvx2(_mm256_loadu_ps(&transforms.rotationY[i]), s1, c1);
+  sinCosAvx2(_mm256_loadu_ps(&transforms.rotationX[i]), s2, c2);
+  sinCosAvx2(_mm256_loadu_ps(&transforms.rotationZ[i]), s3, c3);
+  const __m256 s2s3 = _mm256_mul_ps(s2, s3);
+  const __m256 s2c3 = _mm256_mul_ps(s2, c3);
+  const __m256 axisXx = _mm256_fmadd_ps(c1, c3, _mm256_mul_ps(s1, s2s3));
+  const __m256 axisXy = _mm256_mul_ps(c2, s3);
+  const __m256 axisXz = _mm256_fmsub_ps(c1, s2s3, _mm256_mul_ps(c3, s1));
+  const __m256 axisYx = _mm256_fmsub_ps(s1, s2c3, _mm256_mul_ps(c1, s3));
+  const __m256 axisYy = _mm256_mul_ps(c2, c3);
+  const __m256 axisYz = _mm256_fmadd_ps(c1, s2c3, _mm256_mul_ps(s1, s3));
+  const __m256 axisZx = _mm256_mul_ps(c2, s1);
+  const __m256 axisZy = _mm256_sub_ps(zero, s2);
+  const __m256 axisZz = _mm256_mul_ps(c1, c2);
+
+  const __m256 sx = _mm256_loadu_ps(&transforms.scaleX[i]);
+  const __m256 sy = _mm256_loadu_ps(&transforms.scaleY[i]);
+  const __m256 sz = _mm256_loadu_ps(&transforms.scaleZ[i]);
+  storeColumnAvx2(_mm256_mul_ps(sx, axisXx), _mm256_mul_ps(sx, axisXy), _mm256_mul_ps(sx, axisXz), zero, objects, 0);
+  storeColumnAvx2(_mm256_mul_ps(sy, axisYx), _mm256_mul_ps(sy, axisYy), _mm256_mul_ps(sy, axisYz), zero, objects, 1);
+  storeColumnAvx2(_mm256_mul_ps(sz, axisZx), _mm256_mul_ps(sz, axisZy), _mm256_mul_ps(sz, axisZz), zero, objects, 2);
+  storeColumnAvx2(
+      _mm256_loadu_ps(&transforms.translationX[i]),
+      _mm256_loadu_ps(&transforms.translationY[i]),
+      _mm256_loadu_ps(&transforms.translationZ[i]),
+      one, objects, 3);
+
+  const __m256 isx = _mm256_div_ps(one, sx);
+  const __m256 isy = _mm256_div_ps(one, sy);
+  const __m256 isz = _mm256_div_ps(one, sz);
+  storeColumnAvx2(_mm256_mul_ps(isx, axisXx), _mm256_mul_ps(isx, axisXy), _mm256_mul_ps(isx, axisXz), zero, objects, 4);
+  storeColumnAvx2(_mm256_mul_ps(isy, axisYx), _mm256_mul_ps(isy, axisYy), _mm256_mul_ps(isy, axisYz), zero, objects, 5);
+  storeColumnAvx2(_mm256_mul_ps(isz, axisZx), _mm256_mul_ps(isz, axisZy), _mm256_mul_ps(isz, axisZz), zero, objects, 6);
+  storeColumnAvx2(zero, zero, zero, one, objects, 7);
+}
+
+#endif  // LVE_SIMD_X86
+
+}  // namespace
+
+uint32_t LveTransformSystem::write(LveObjectBuffer &objectBuffer, uint32_t firstObject, LveWorkerPool *workers) {
+  assert(firstObject + count <= objectBuffer.getObjectCount() && "Allocate the transforms' slots first");
+  if (objectBuffer.getRecreateCount() != objectBufferRecreateCount || firstObject != lastFirstObject) {
+    objectBufferRecreateCount = objectBuffer.getRecreateCount();
+    lastFirstObject = firstObject;
+    markAllDirty();
+  }
+  return write(
+      objectBuffer.getFrameObjects() + firstObject,
+      static_cast<uint32_t>(objectBuffer.getFrameIndex()),
+      workers);
+}
+
+uint32_t LveTransformSystem::write(
+    ObjectData *objects, uint32_t frameIndex, LveWorkerPool *workers, LveSimdPath path) {
+  assert(isSimdPathSupported(path) && "Transform path not supported on this CPU");
+  assert(frameIndex < frameCount && "Frame index out of range");
+  if (dirtyCount == 0) {
+    return 0;
+  }
+  const uint32_t jobCount = (paddedSize() + JOB_SIZE - 1) / JOB_SIZE;
+  // per job, so the jobs share no counters
+  std::vector<uint32_t> written(jobCount, 0);
+  std::vector<uint32_t> cleaned(jobCount, 0);
+  const uint8_t frameBit = static_cast<uint8_t>(1u << frameIndex);
+  // the frame's bit in every lane of a batch
+  const uint64_t batchBits = 0x0101010101010101ull * frameBit;
+
+  auto job = [&](uint32_t jobIndex, uint32_t) {
+    ObjectData scratch[LANES];
+    const uint32_t end = std::min((jobIndex + 1) * JOB_SIZE, paddedSize());
+    for (uint32_t first = jobIndex * JOB_SIZE; first < end; first += LANES) {
+      uint64_t pending;
+      static_assert(sizeof(pending) == LANES, "One compare per batch");
+      std::memcpy(&pending, &pendingFrames[first], sizeof(pending));
+      if ((pending & batchBits) == 0) continue;
+
+      // the clean lanes of a dirty batch are written again with the matrices they already have,
+      // the padding lanes of the last batch go to scratch memory
+      const bool tail = first + LANES > count;
+      ObjectData *out = tail ? scratch : objects + first;
+      switch (path) {
+#ifdef LVE_SIMD_X86
+        case LveSimdPath::Avx2:
+          writeAvx2(*this, first, out);
+          break;
+        case LveSimdPath::Sse:
+          writeSse(*this, first, out);
+          break;
+#endif
+        default:
+          writeScalar(*this, first, out);
+          break;
+      }
+      const uint32_t laneCount = tail ? count - first : LANES;
+      for (uint32_t lane = 0; lane < laneCount; lane++) {
+        if (tail) {
+          objects[first + lane].modelMatrix = scratch[lane].modelMatrix;
+          objects[first + lane].normalMatrix = scratch[lane].normalMatrix;
+        }
+        uint8_t &frames = pendingFrames[first + lane];
+        if ((frames & frameBit) == 0) continue;
+        written[jobIndex]++;
+        frames &= static_cast<uint8_t>(~frameBit);
+        if (frames == 0) cleaned[jobIndex]++;
+      }
+    }
+  };
+  if (workers != nullptr && jobCount > 1) {
+    workers->run(jobCount, job);
+  } else {
+    for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) job(jobIndex, 0);
+  }
+
+  uint32_t writtenCount = 0;
+  for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+    writtenCount += written[jobIndex];
+    dirtyCount -= cleaned[jobIndex];
+  }
+  return writtenCount;
+}
+
+}  // namespace lve
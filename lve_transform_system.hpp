@@ -0,0 +1,95 @@
+#pragma once
+
+#include "lve_object_buffer.hpp"
+#include "lve_simd.hpp"
+#include "lve_worker_pool.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Translation, rotation and scale of many objects in structure-of-arrays form, turned into model
+ * and normal matrices LANES objects at a time.
+ *
+ * Transform i owns slot firstObject + i of every frame's region in an LveObjectBuffer and its
+ * matrices are written there directly, no matrix is kept on the cpu. A changed transform has to
+ * reach the region of every frame in flight, so it keeps a pending bit per frame slot and stays
+ * dirty until write() was called with each of them. Slots may come in any order, the renderer
+ * starts over at slot 0 when the swap chain is recreated.
+ * Unchanged transforms are skipped a whole batch at a time, static scenes cost a byte compare per
+ * LANES objects. The same convention as TransformComponent: Translate * Ry * Rx * Rz * Scale.
+ *
+ * The SIMD sine and cosine are accurate to a few ulp for angles below 8192 radians.
+ */
+class LveTransformSystem {
+ public:
+  static constexpr uint32_t LANES = 8;
+  // transforms per worker job, a multiple of LANES
+  static constexpr uint32_t JOB_SIZE = 16384;
+  // one pending bit per frame slot
+  static constexpr uint32_t MAX_FRAME_COUNT = 8;
+
+  explicit LveTransformSystem(uint32_t frameCount);
+
+  // every transform is written again into every frame slot
+  void setFrameCount(uint32_t count);
+  void clear();
+  // drops the transforms from count on, the others keep their pending writes
+  void truncate(uint32_t count);
+  void reserve(uint32_t count);
+  // returns the transform's index, its slot in the object buffer relative to firstObject
+  uint32_t add(const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale);
+  void set(uint32_t index, const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale);
+  void setTranslation(uint32_t index, const glm::vec3 &translation);
+  void setRotation(uint32_t index, const glm::vec3 &rotation);
+  void setScale(uint32_t index, const glm::vec3 &scale);
+  glm::vec3 getTranslation(uint32_t index) const;
+  glm::vec3 getRotation(uint32_t index) const;
+  glm::vec3 getScale(uint32_t index) const;
+  // e.g. after the slots were overwritten by something else
+  void markAllDirty();
+
+  uint32_t getFrameCount() const { return frameCount; }
+  uint32_t size() const { return count; }
+  // size() rounded up to LANES
+  uint32_t paddedSize() const { return static_cast<uint32_t>(pendingFrames.size()); }
+  uint32_t getDirtyCount() const { return dirtyCount; }
+
+  // writes the matrices the current frame's region lacks, call once per frame after the object
+  // buffer's beginFrame. Everything is rewritten when the buffer was recreated. Returns the number
+  // of transforms written
+  uint32_t write(LveObjectBuffer &objectBuffer, uint32_t firstObject, LveWorkerPool *workers = nullptr);
+  // the same into objects[0, size()), the region of frame slot frameIndex. Only the two matrices
+  // of each ObjectData are touched
+  uint32_t write(
+      ObjectData *objects,
+      uint32_t frameIndex,
+      LveWorkerPool *workers = nullptr,
+      LveSimdPath path = bestSimdPath());
+
+  std::vector<float> translationX, translationY, translationZ;
+  std::vector<float> rotationX, rotationY, rotationZ;
+  std::vector<float> scaleX, scaleY, scaleZ;
+
+ private:
+  void markDirty(uint32_t index);
+
+  uint32_t frameCount;
+  uint32_t count = 0;
+  // bit f is set while the region of frame slot f lacks the transform's current matrices
+  std::vector<uint8_t> pendingFrames;
+  // transforms with any pending bit
+  uint32_t dirtyCount = 0;
+  // where write() put the matrices last time, other slots hold nothing of ours
+  uint32_t objectBufferRecreateCount = 0;
+  uint32_t lastFirstObject = 0;
+};
+
+}  // namespace lve
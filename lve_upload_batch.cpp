@@ -0,0 +1,230 @@
+#include "lve_upload_batch.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+LveUploadBatch::LveUploadBatch(LveDevice &device)
+    : lveDevice{device}, stagingRing{device.stagingRing()} {}
+
+LveUploadBatch::~LveUploadBatch() {
+  if (hasPendingCommands()) {
+    submit();
+  }
+  wait();
+}
+
+VkCommandBuffer LveUploadBatch::getCommandBuffer() {
+  if (commandBuffer == VK_NULL_HANDLE) {
+    commandBuffer = lveDevice.beginSingleTimeCommands();
+  }
+  return commandBuffer;
+}
+
+/**
+ * Copies data into the staging ring, submitting the batch early when the ring is full of data
+ * this batch has not submitted yet. Uploads the ring cannot take (larger than the ring, or blocked
+ * by another batch's unsubmitted data) get a staging buffer of their own
+ *
+ * @param alignment Required alignment of the staging offset (4 for buffer copies, texel size for
+ * images)
+ *
+ * @return Staging buffer and offset holding the copied data
+ */
+LveUploadBatch::StagingAllocation LveUploadBatch::stage(
+    const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+  uploadCount++;
+  uploadedBytes += size;
+
+  if (size <= stagingRing.getCapacity()) {
+    LveStagingRing::Allocation allocation{};
+    bool allocated = stagingRing.allocate(getStagingRegion(), size, alignment, allocation);
+    if (!allocated && hasPendingCommands()) {
+      // our own open region may hold the space we need, hand it to the GPU and try again
+      submit();
+      allocated = stagingRing.allocate(getStagingRegion(), size, alignment, allocation);
+    }
+    if (allocated) {
+      memcpy(allocation.mapped, data, size);
+      return {allocation.buffer, allocation.offset};
+    }
+  }
+
+  auto staging = std::make_unique<LveBuffer>(
+      lveDevice,
+      size,
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  staging->map();
+  staging->writeToBuffer(const_cast<void *>(data), size);
+  VkBuffer buffer = staging->getBuffer();
+  dedicatedStaging.push_back(std::move(staging));
+  return {buffer, 0};
+}
+
+uint64_t LveUploadBatch::getStagingRegion() {
+  if (stagingRegion == 0) {
+    stagingRegion = stagingRing.openRegion();
+  }
+  return stagingRegion;
+}
+
+void LveUploadBatch::uploadBuffer(
+    const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+  assert(size > 0 && "Cannot upload an empty range");
+  auto staging = stage(data, size, 4);
+
+  VkBufferCopy copyRegion{};
+  copyRegion.srcOffset = staging.offset;
+  copyRegion.dstOffset = dstOffset;
+  copyRegion.size = size;
+  vkCmdCopyBuffer(getCommandBuffer(), staging.buffer, dstBuffer, 1, &copyRegion);
+}
+
+void LveUploadBatch::uploadImage(
+    const void *data,
+    VkDeviceSize size,
+    VkImage dstImage,
+    uint32_t width,
+    uint32_t height,
+    uint32_t layerCount) {
+  assert(size > 0 && "Cannot upload an empty image");
+  auto staging = stage(data, size, 16);
+  VkCommandBuffer cmd = getCommandBuffer();
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = dstImage;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = layerCount;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      cmd,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = staging.offset;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = layerCount;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyBufferToImage(
+      cmd,
+      staging.buffer,
+      dstImage,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      1,
+      &region);
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(
+      cmd,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+}
+
+uint64_t LveUploadBatch::submit() {
+  if (!hasPendingCommands()) {
+    return submissions.empty() ? 0 : submissions.back().serial;
+  }
+
+  // make every transfer write visible to whatever reads the resources afterwards
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+                                VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+          VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &memoryBarrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record upload command buffer!");
+  }
+
+  Submission submission{};
+  submission.commandBuffer = commandBuffer;
+  submission.dedicatedStaging = std::move(dedicatedStaging);
+  // a batch that only used dedicated staging still needs the fence to know when to free it
+  submission.serial = getStagingRegion();
+  stagingRegion = 0;
+  VkFence fence = stagingRing.closeRegion(submission.serial);
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &submission.commandBuffer;
+  if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit upload command buffer!");
+  }
+
+  submissions.push_back(std::move(submission));
+  commandBuffer = VK_NULL_HANDLE;
+  dedicatedStaging.clear();
+  submitCount++;
+  return submissions.back().serial;
+}
+
+void LveUploadBatch::wait() {
+  if (submissions.empty()) {
+    return;
+  }
+
+  for (auto &submission : submissions) {
+    stagingRing.wait(submission.serial);
+    vkFreeCommandBuffers(
+        lveDevice.device(),
+        lveDevice.getTransientCommandPool(),
+        1,
+        &submission.commandBuffer);
+  }
+  submissions.clear();
+}
+
+}  // namespace lve
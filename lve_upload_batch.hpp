@@ -0,0 +1,87 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_staging_ring.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+/*
+ * Collects many buffer and image uploads into a single command buffer.
+ *
+ * Every upload is copied into the device's persistent staging ring and a copy command is recorded.
+ * Nothing reaches the GPU until submit() is called, which ends the command buffer and submits it
+ * once with the fence of the batch's own ring region. When the ring fills up with this batch's
+ * unsubmitted data the batch submits early, so a batch may take a handful of submits but never one
+ * per upload. Uploads the ring cannot hold get a dedicated staging buffer.
+ */
+class LveUploadBatch {
+ public:
+  LveUploadBatch(LveDevice &device);
+  ~LveUploadBatch();
+
+  LveUploadBatch(const LveUploadBatch &) = delete;
+  LveUploadBatch &operator=(const LveUploadBatch &) = delete;
+
+  void uploadBuffer(
+      const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+  // transitions the whole image to TRANSFER_DST, copies and leaves it in SHADER_READ_ONLY
+  void uploadImage(
+      const void *data,
+      VkDeviceSize size,
+      VkImage dstImage,
+      uint32_t width,
+      uint32_t height,
+      uint32_t layerCount = 1);
+
+  // submits everything recorded so far, returns the region to pass to LveStagingRing::wait
+  uint64_t submit();
+  // blocks until every submitted upload has finished and releases its staging memory
+  void wait();
+  void submitAndWait() {
+    submit();
+    wait();
+  }
+
+  bool hasPendingCommands() const { return commandBuffer != VK_NULL_HANDLE; }
+  uint32_t getSubmitCount() const { return submitCount; }
+  uint32_t getUploadCount() const { return uploadCount; }
+  VkDeviceSize getUploadedBytes() const { return uploadedBytes; }
+
+ private:
+  struct StagingAllocation {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+  };
+
+  struct Submission {
+    VkCommandBuffer commandBuffer;
+    // the staging ring region the submit consumed
+    uint64_t serial;
+    // uploads the ring could not take get a staging buffer of their own
+    std::vector<std::unique_ptr<LveBuffer>> dedicatedStaging;
+  };
+
+  VkCommandBuffer getCommandBuffer();
+  StagingAllocation stage(const void *data, VkDeviceSize size, VkDeviceSize alignment);
+  // the batch's open staging ring region, opened on first use after each submit
+  uint64_t getStagingRegion();
+
+  LveDevice &lveDevice;
+  LveStagingRing &stagingRing;
+
+  VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+  uint64_t stagingRegion = 0;
+  std::vector<std::unique_ptr<LveBuffer>> dedicatedStaging;
+  std::vector<Submission> submissions;
+
+  uint32_t submitCount = 0;
+  uint32_t uploadCount = 0;
+  VkDeviceSize uploadedBytes = 0;
+};
+
+}  // namespace lve
@@ -0,0 +1,114 @@
+#include "lve_worker_pool.hpp"
+
+#include "lve_profiler.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+LveWorkerPool::LveWorkerPool(uint32_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for (uint32_t i = 1; i < threadCount; i++) {
+    threads.emplace_back(&LveWorkerPool::workerLoop, this, i);
+  }
+}
+
+LveWorkerPool::~LveWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void LveWorkerPool::run(uint32_t jobCount, const Job &job) {
+  if (jobCount == 0) {
+    return;
+  }
+  // nothing to share, skip the wake up
+  if (jobCount == 1 || threads.empty()) {
+    for (uint32_t i = 0; i < jobCount; i++) {
+      job(i, 0);
+    }
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    // a worker that woke up late for the previous batch must be out before the counters reset
+    done.wait(lock, [this]() { return activeWorkers == 0; });
+    currentJob = &job;
+    currentJobCount = jobCount;
+    nextJob.store(0, std::memory_order_relaxed);
+    remainingJobs.store(jobCount, std::memory_order_relaxed);
+    error = nullptr;
+    generation++;
+  }
+  wake.notify_all();
+
+  runJobs(job, jobCount, 0);
+
+  std::unique_lock<std::mutex> lock{mutex};
+  done.wait(lock, [this]() {
+    return remainingJobs.load(std::memory_order_acquire) == 0 && activeWorkers == 0;
+  });
+  currentJob = nullptr;
+  if (error) {
+    std::exception_ptr jobError = error;
+    error = nullptr;
+    std::rethrow_exception(jobError);
+  }
+}
+
+void LveWorkerPool::runJobs(const Job &job, uint32_t jobCount, uint32_t threadIndex) {
+  uint32_t jobIndex;
+  while ((jobIndex = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobCount) {
+    try {
+      job(jobIndex, threadIndex);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+    remainingJobs.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void LveWorkerPool::workerLoop(uint32_t threadIndex) {
+  LVE_PROFILE_THREAD("worker");
+  uint64_t seenGeneration = 0;
+  while (true) {
+    const Job *job;
+    uint32_t jobCount;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+      job = currentJob;
+      jobCount = currentJobCount;
+      activeWorkers++;
+    }
+
+    if (job) {
+      runJobs(*job, jobCount, threadIndex);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      activeWorkers--;
+    }
+    done.notify_all();
+  }
+}
+
+}  // namespace lve
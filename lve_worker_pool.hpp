@@ -0,0 +1,61 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+/*
+ * A fixed set of threads that run batches of jobs.
+ *
+ * run() hands out job indices from an atomic counter until every job of the batch is done and only
+ * returns after that, so jobs can capture locals by reference. The calling thread takes jobs as
+ * well and is thread index 0, the pool's own threads are 1..getThreadCount()-1. Jobs can use the
+ * thread index to pick per-thread resources (command pools, scratch memory) without locking.
+ */
+class LveWorkerPool {
+ public:
+  using Job = std::function<void(uint32_t jobIndex, uint32_t threadIndex)>;
+
+  // threadCount includes the calling thread, 0 uses every hardware thread
+  explicit LveWorkerPool(uint32_t threadCount = 0);
+  ~LveWorkerPool();
+
+  LveWorkerPool(const LveWorkerPool &) = delete;
+  LveWorkerPool &operator=(const LveWorkerPool &) = delete;
+
+  // blocks until every job finished, rethrows the first exception a job threw. Not reentrant, a
+  // job must not call run() itself
+  void run(uint32_t jobCount, const Job &job);
+
+  uint32_t getThreadCount() const { return static_cast<uint32_t>(threads.size()) + 1; }
+
+ private:
+  void workerLoop(uint32_t threadIndex);
+  void runJobs(const Job &job, uint32_t jobCount, uint32_t threadIndex);
+
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool stopping = false;
+  uint64_t generation = 0;
+  // workers that picked up the current batch and have not left it yet
+  uint32_t activeWorkers = 0;
+
+  const Job *currentJob = nullptr;
+  uint32_t currentJobCount = 0;
+  std::atomic<uint32_t> nextJob{0};
+  std::atomic<uint32_t> remainingJobs{0};
+  std::exception_ptr error;
+};
+
+}  // namespace lve
@@ -12,6 +12,12 @@
 
 namespace lve {
 
+struct PointLightPushConstants {
+    glm::vec4 position{};
+    glm::vec4 color{};
+    float radius;
+};
+
 PointLightSytem::PointLightSytem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device} {
     
     createPipelineLayout(globalSetLayout);
@@ -26,11 +32,11 @@ PointLightSytem::~PointLightSytem() {
 
 void PointLightSytem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
 
-    //VkPushConstantRange pushConstantRange{};
-    //pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     // offset is for if you use seperate vertex and fragment bit. It is 0 since we use them together
-    //pushConstantRange.offset = 0;
-    //pushConstantRange.size = sizeof(SimplePushConstantData);
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PointLightPushConstants);
 
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
 
@@ -38,8 +44,8 @@ void PointLightSytem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges =nullptr;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
     if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout");
@@ -64,13 +70,56 @@ void PointLightSytem::createPipeline(VkRenderPass renderPass) {
 }
 
 
+void PointLightSytem::update(FrameInfo& frameInfo, GlobalUbo& ubo){
+    // lights past MAX_LIGHTS are dropped, the ubo has no room for them
+    int lightIndex = 0;
+    frameInfo.world.each<TransformComponent, PointLightComponent>([&](LveEntity, TransformComponent &transform, PointLightComponent &light) {
+        if (lightIndex >= MAX_LIGHTS) return;
+        ubo.pointLights[lightIndex].position = glm::vec4(transform.getTranslation(), 1.f);
+        ubo.pointLights[lightIndex].color = glm::vec4(light.color, light.lightIntensity);
+        lightIndex++;
+    });
+    ubo.numLights = lightIndex;
+}
+
 void PointLightSytem::render(FrameInfo& frameInfo){
-    lvePipeline->bind(frameInfo.commandBuffer);
+    // a scene without lights records nothing, not even the pipeline bind
+    if (frameInfo.world.count<TransformComponent, PointLightComponent>() == 0) return;
+    if (frameInfo.secondaryRecorder) {
+        // a handful of draws, one secondary recorded on this thread
+        frameInfo.secondaryRecorder->record(1, [&](VkCommandBuffer commandBuffer, uint32_t) {
+            recordLights(frameInfo, commandBuffer);
+        });
+    } else {
+        recordLights(frameInfo, frameInfo.commandBuffer);
+    }
+}
+
+void PointLightSytem::recordLights(FrameInfo& frameInfo, VkCommandBuffer commandBuffer){
+    LveGpuZone gpuZone{frameInfo.gpuProfiler, commandBuffer, "point light system"};
+    lvePipeline->bind(commandBuffer);
 
     vkCmdBindDescriptorSets(
-        frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr
+        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr
     );
-    vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+    // the same lights update() put in the ubo, in the same order
+    int lightCount = 0;
+    frameInfo.world.each<TransformComponent, PointLightComponent>([&](LveEntity, TransformComponent &transform, PointLightComponent &light) {
+        if (lightCount++ >= MAX_LIGHTS) return;
+        PointLightPushConstants push{};
+        push.position = glm::vec4(transform.getTranslation(), 1.f);
+        push.color = glm::vec4(light.color, light.lightIntensity);
+        push.radius = transform.getScale().x;
+
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(PointLightPushConstants),
+            &push);
+        vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+    });
 }
 
 
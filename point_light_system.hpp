@@ -18,12 +18,15 @@ namespace lve {
         ~PointLightSytem();
         PointLightSytem(const PointLightSytem&) = delete;
         PointLightSytem& operator=(const PointLightSytem&) = delete;
+        // copies every point light object into the ubo
+        void update(FrameInfo& frameInfo, GlobalUbo& ubo);
         void render(FrameInfo& frameInfo);
     
     private:
 
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
         void createPipeline(VkRenderPass renderPass);
+        void recordLights(FrameInfo& frameInfo, VkCommandBuffer commandBuffer);
 
         LveDevice &lveDevice;
         
@@ -3,18 +3,31 @@
 layout (location = 0) in vec2 fragOffset;
 layout (location = 0) out vec4 outColor;
 
+#define MAX_LIGHTS 64
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
 layout(set = 0, binding = 0) uniform GlobalUbo{
     mat4 projection;
     mat4 view;
     vec4 ambientLightColor;
-    vec3 LightPosition;
-    vec4 lightColor;
+    PointLight pointLights[MAX_LIGHTS];
+    int numLights;
 } ubo;
 
+layout(push_constant) uniform Push {
+    vec4 position;
+    vec4 color;
+    float radius;
+} push;
+
 void main(){
     float dis = sqrt(dot(fragOffset, fragOffset));
     if(dis>=1.0){
         discard;
     }
-    outColor = vec4(ubo.lightColor.xyz, 1.0);
+    outColor = vec4(push.color.xyz, 1.0);
 }
\ No newline at end of file
@@ -11,24 +11,35 @@ const vec2 OFFSETS[6] = vec2[](
 
 layout (location = 0) out vec2 fragOffset;
 
+#define MAX_LIGHTS 64
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
 layout(set = 0, binding = 0) uniform GlobalUbo{
     mat4 projection;
     mat4 view;
     vec4 ambientLightColor;
-    vec3 LightPosition;
-    vec4 lightColor;
+    PointLight pointLights[MAX_LIGHTS];
+    int numLights;
 } ubo;
 
-const float LIGHT_RADIUS = 0.1;
+layout(push_constant) uniform Push {
+    vec4 position;
+    vec4 color;
+    float radius;
+} push;
 
 void main(){
     fragOffset = OFFSETS[gl_VertexIndex];
     vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
     vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-    vec3 positionWorld = ubo.LightPosition.xyz
-        + LIGHT_RADIUS * fragOffset.x * cameraRightWorld
-        + LIGHT_RADIUS * fragOffset.y * cameraUpWorld;
+    vec3 positionWorld = push.position.xyz
+        + push.radius * fragOffset.x * cameraRightWorld
+        + push.radius * fragOffset.y * cameraUpWorld;
     gl_Position = ubo.projection * ubo.view * vec4(positionWorld,1.0);
     
 }
\ No newline at end of file
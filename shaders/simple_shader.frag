@@ -6,27 +6,33 @@ layout (location = 2) in vec3 fragNormalWorld;
 
 layout(location = 0) out vec4 outColor;
 
+#define MAX_LIGHTS 64
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
 layout(set = 0, binding = 0) uniform GlobalUbo{
     mat4 projection;
     mat4 view;
     vec4 ambientLightColor;
-    vec3 LightPosition;
-    vec4 lightColor;
+    PointLight pointLights[MAX_LIGHTS];
+    int numLights;
 } ubo;
 
-layout (push_constant) uniform Push {
-    mat4 modelMatrix;
-    mat4 normalMatrix;
-} push;
-
 void main()
 {
-    outColor = vec4(fragColor, 1.0);
-    vec3 directionToLight = ubo.LightPosition - fragPosWorld;
-    float attenuation = 1.0 / dot(directionToLight, directionToLight); //distance squared
+    vec3 diffuceLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+    vec3 surfaceNormal = normalize(fragNormalWorld);
 
-    vec3 lightColor = ubo.lightColor.xyz * ubo.lightColor.w * attenuation;
-    vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
-    vec3 diffuceLight = lightColor * max(dot(normalize(fragNormalWorld), normalize(directionToLight)),0);
-    outColor = vec4((diffuceLight + ambientLight) * fragColor,1.0);
+    for (int i = 0; i < ubo.numLights; i++) {
+        PointLight light = ubo.pointLights[i];
+        vec3 directionToLight = light.position.xyz - fragPosWorld;
+        float attenuation = 1.0 / dot(directionToLight, directionToLight); //distance squared
+        float cosAngIncidence = max(dot(surfaceNormal, normalize(directionToLight)), 0);
+        vec3 intensity = light.color.xyz * light.color.w * attenuation;
+        diffuceLight += intensity * cosAngIncidence;
+    }
+    outColor = vec4(diffuceLight * fragColor, 1.0);
 }
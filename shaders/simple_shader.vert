@@ -9,30 +9,55 @@ layout (location = 0) out vec3 fragColor;
 layout (location = 1) out vec3 fragPosWorld;
 layout (location = 2) out vec3 fragNormalWorld;
 
+#define MAX_LIGHTS 64
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
 layout(set = 0, binding = 0) uniform GlobalUbo{
     mat4 projection;
     mat4 view;
     vec4 ambientLightColor;
-    vec3 LightPosition;
-    vec4 lightColor;
+    PointLight pointLights[MAX_LIGHTS];
+    int numLights;
 } ubo;
 
-layout (push_constant) uniform Push {
-    mat4 modelMatrix; 
+struct ObjectData {
+    mat4 modelMatrix;
     mat4 normalMatrix;
-} push;
+    vec4 boundingSphere;
+    uint materialIndex;
+    uint drawIndex;
+    uint visibilityIndex;
+};
+
+// firstInstance of each draw selects the object
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// set for the draws the cull pass filled, their instances are entries of the instance table
+layout(constant_id = 0) const bool CULLED_INSTANCES = false;
+
+layout(std430, set = 1, binding = 1) readonly buffer InstanceBuffer {
+    uint objects[];
+} instanceBuffer;
 
 
 void main(){
+    uint objectIndex = CULLED_INSTANCES ? instanceBuffer.objects[gl_InstanceIndex] : uint(gl_InstanceIndex);
+    ObjectData object = objectBuffer.objects[objectIndex];
     //we should convert modelMatrix to position matrix since the point light in the world space
-    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
     gl_Position = ubo.projection * ubo.view * positionWorld;
     
     // Calculating the inverse in a shader can be expensive and should be avoided
     //mat3 normalMatrix = transpose(inverse(mat3(push.modelMatrix)));
     //vec3 normalWorldSpace = normalize(normalMatrix * normal);
 
-    fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+    fragNormalWorld = normalize(mat3(object.normalMatrix) * normal);
     fragPosWorld = positionWorld.xyz;
     
     fragColor = color;
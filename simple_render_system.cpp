@@ -1,24 +1,20 @@
 #include "simple_render_system.hpp"
+#include "lve_profiler.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
-struct SimplePushConstantData{
-    glm::mat4 modelMatrix{1.f};
-    glm::mat4 normalMatrix{1.f};
-};
-
-
 namespace lve {
 
-SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device} {
+SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout) : lveDevice{device} {
     
-    createPipelineLayout(globalSetLayout);
+    createPipelineLayout(globalSetLayout, objectSetLayout);
     createPipeline(renderPass);
 }
 
@@ -28,22 +24,17 @@ SimpleRenderSystem::~SimpleRenderSystem() {
 
 
 
-void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout) {
 
-    VkPushConstantRange pushConstantRange{};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-    // offset is for if you use seperate vertex and fragment bit. It is 0 since we use them together
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(SimplePushConstantData);
-
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+    // per object matrices come from the object buffer (set 1) instead of push constants
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, objectSetLayout};
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
     if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout");
@@ -63,31 +54,375 @@ void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
         "shaders/simple_shader.vert.spv",
         "shaders/simple_shader.frag.spv",
         pipelineConfig);
+
+    // CULLED_INSTANCES in simple_shader.vert
+    VkBool32 culledInstances = VK_TRUE;
+    VkSpecializationMapEntry specializationEntry{0, 0, sizeof(VkBool32)};
+    VkSpecializationInfo specializationInfo{1, &specializationEntry, sizeof(VkBool32), &culledInstances};
+    pipelineConfig.vertexSpecializationInfo = &specializationInfo;
+    culledPipeline = std::make_unique<LvePipeline>(
+        lveDevice,
+        "shaders/simple_shader.vert.spv",
+        "shaders/simple_shader.frag.spv",
+        pipelineConfig);
 }
 
 
-void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo){
-    lvePipeline->bind(frameInfo.commandBuffer);
+void SimpleRenderSystem::bindFrameState(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, bool culled) {
+    (culled ? culledPipeline : lvePipeline)->bind(commandBuffer);
 
     vkCmdBindDescriptorSets(
-        frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr
+        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr
     );
+    frameInfo.objectBuffer.bind(commandBuffer, pipelineLayout, 1);
+}
+
+void SimpleRenderSystem::buildBatches(FrameInfo& frameInfo, bool frustumCull) {
+    LVE_PROFILE_FUNCTION();
+    for (auto &kv: batches) kv.second.objects.clear();
+    auto addToBatch = [&](const DrawObject &obj) {
+        auto &batch = batches[obj.mesh->model.get()];
+        batch.model = obj.mesh->model.get();
+        batch.objects.push_back(obj);
+    };
+    // only the archetypes with a transform and a mesh are visited, lights and the viewer are not
+    if (frustumCull) {
+        cullCandidates.clear();
+        cullBounds.clear();
+        frameInfo.world.eachChunk<TransformComponent, MeshComponent>(
+            [&](uint32_t count, const LveEntity *entities, TransformComponent *transforms, MeshComponent *meshes) {
+                for (uint32_t i = 0; i < count; i++) {
+                    if (meshes[i].model == nullptr) continue;
+                    // cached on the mesh, static entities cost no matrix here
+                    const WorldBounds &bounds = meshes[i].getWorldBounds(transforms[i]);
+                    cullCandidates.push_back({&transforms[i], &meshes[i], entities[i]});
+                    cullBounds.add(bounds.center, bounds.radius, bounds.halfExtent);
+                }
+            });
+        LveFrustum frustum = LveFrustum::fromViewProjection(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        uint32_t visibleCount = LveFrustumCuller::cullBoxes(frustum, cullBounds, visibleCandidates);
+        for (uint32_t i = 0; i < visibleCount; i++) addToBatch(cullCandidates[visibleCandidates[i]]);
+    } else {
+        frameInfo.world.eachChunk<TransformComponent, MeshComponent>(
+            [&](uint32_t count, const LveEntity *entities, TransformComponent *transforms, MeshComponent *meshes) {
+                for (uint32_t i = 0; i < count; i++) {
+                    if (meshes[i].model != nullptr) addToBatch({&transforms[i], &meshes[i], entities[i]});
+                }
+            });
+    }
+
+    sortedBatches.clear();
+    for (auto it = batches.begin(); it != batches.end();) {
+        // a model no object uses anymore may be destroyed, its pointer must not stay a key
+        if (it->second.objects.empty()) {
+            it = batches.erase(it);
+            continue;
+        }
+        sortedBatches.push_back(&it->second);
+        ++it;
+    }
+    // pooled models share their buffers, batches from the same page need no rebinding in between
+    std::sort(sortedBatches.begin(), sortedBatches.end(), [](const Batch* a, const Batch* b) {
+        return a->model->getVertexBuffer() < b->model->getVertexBuffer();
+    });
+
+    drawList.clear();
+    for (auto *batch: sortedBatches) {
+        batch->first = drawList.size();
+        batch->count = batch->objects.size();
+        batch->drawIndex = ObjectData::NO_DRAW;
+        drawList.insert(drawList.end(), batch->objects.begin(), batch->objects.end());
+    }
+}
+
+std::vector<SimpleRenderSystem::Batch*>::iterator SimpleRenderSystem::batchAt(size_t index) {
+    auto batchIt = std::upper_bound(sortedBatches.begin(), sortedBatches.end(), index, [](size_t index, const Batch* batch) {
+        return index < batch->first;
+    });
+    if (batchIt != sortedBatches.begin()) --batchIt;
+    return batchIt;
+}
+
+void SimpleRenderSystem::updateTransforms(FrameInfo& frameInfo, uint32_t firstObject) {
+    LVE_PROFILE_FUNCTION();
+    if (transforms.getFrameCount() != frameInfo.objectBuffer.getFrameCount()) {
+        transforms.setFrameCount(frameInfo.objectBuffer.getFrameCount());
+    }
+    uint32_t count = static_cast<uint32_t>(drawList.size());
+    transforms.truncate(count);
+    transformSlots.resize(std::min<size_t>(transformSlots.size(), count));
+    for (uint32_t i = 0; i < count; i++) {
+        const DrawObject &obj = drawList[i];
+        const TransformComponent &transform = *obj.transform;
+        if (i == transforms.size()) {
+            transforms.add(transform.getTranslation(), transform.getRotation(), transform.getScale());
+            transformSlots.push_back({obj.entity, transform.getVersion()});
+            continue;
+        }
+        // static entities keep their slot from frame to frame and cost this compare only
+        TransformSlot &slot = transformSlots[i];
+        if (slot.entity == obj.entity && slot.version == transform.getVersion()) continue;
+        transforms.set(i, transform.getTranslation(), transform.getRotation(), transform.getScale());
+        slot = {obj.entity, transform.getVersion()};
+    }
+    // most of the game engines don't handle the projection on cpu
+    // they handle it on gpu through shaders instead
+    LveWorkerPool *workers = frameInfo.secondaryRecorder ? &frameInfo.secondaryRecorder->getWorkerPool() : nullptr;
+    transforms.write(frameInfo.objectBuffer, firstObject, workers);
+}
+
+void SimpleRenderSystem::writeObjects(FrameInfo& frameInfo, uint32_t firstObject, size_t begin, size_t end) {
+    ObjectData *objects = frameInfo.objectBuffer.getFrameObjects() + firstObject;
+    for (auto batchIt = batchAt(begin); batchIt != sortedBatches.end() && (*batchIt)->first < end; ++batchIt) {
+        const Batch &batch = **batchIt;
+        size_t writeEnd = std::min(batch.first + batch.count, end);
+        for (size_t i = std::max(batch.first, begin); i < writeEnd; i++) {
+            const DrawObject &obj = drawList[i];
+            ObjectData &object = objects[i];
+            object.boundingSphere = batch.model->getBoundingSphere();
+            object.materialIndex = obj.mesh->materialIndex;
+            object.drawIndex = batch.drawIndex;
+            object.visibilityIndex = obj.entity.index;
+        }
+    }
+}
+
+void SimpleRenderSystem::recordRange(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstObject, size_t begin, size_t end) {
+    writeObjects(frameInfo, firstObject, begin, end);
+
+    // the objects of a batch are consecutive in the object buffer, so one draw covers all of them
+    // with gl_InstanceIndex running from firstInstance. A range can start or end inside a batch
+    auto batchIt = batchAt(begin);
+
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    for (; batchIt != sortedBatches.end() && (*batchIt)->first < end; ++batchIt) {
+        const Batch &batch = **batchIt;
+        size_t drawBegin = std::max(batch.first, begin);
+        size_t drawEnd = std::min(batch.first + batch.count, end);
+        if (drawBegin >= drawEnd) continue;
+        if (batch.model->getVertexBuffer() != boundVertexBuffer) {
+            batch.model->bind(commandBuffer);
+            boundVertexBuffer = batch.model->getVertexBuffer();
+        }
+        batch.model->draw(commandBuffer, firstObject + static_cast<uint32_t>(drawBegin), static_cast<uint32_t>(drawEnd - drawBegin));
+    }
+}
+
+void SimpleRenderSystem::cullGameObjects(FrameInfo& frameInfo, GpuCullSystem& cullSystem, bool occlusion) {
+    LVE_PROFILE_FUNCTION();
+    assert(frameInfo.indirectBuffer != nullptr && "Gpu culling draws through the indirect buffer");
+    buildBatches(frameInfo);
+    uint32_t firstObject = frameInfo.objectBuffer.allocate(static_cast<uint32_t>(drawList.size()));
+    // the draw indices must be known before the objects are written
+    buildCulledCommands(frameInfo, cullSystem, occlusion);
+    updateTransforms(frameInfo, firstObject);
+    writeObjects(frameInfo, firstObject, 0, drawList.size());
+    frameInfo.objectBuffer.flush();
+    cullSystem.cull(
+        frameInfo,
+        firstObject,
+        static_cast<uint32_t>(drawList.size()),
+        occlusion ? CullPass::Early : CullPass::Single);
+    culledOnGpu = true;
+    culledFirstObject = firstObject;
+    occlusionCulled = occlusion;
+}
 
-    for(auto &kv: frameInfo.gameObjects){
-        auto &obj = kv.second;
-        if(obj.model == nullptr) continue;
-        SimplePushConstantData push{};
-        // most of the game engines don't handle the projection on cpu
-        // they handle it on gpu through shaders instead
-        
-        push.modelMatrix = obj.transform.mat4();
-        push.normalMatrix = obj.transform.normalMatrix();
+void SimpleRenderSystem::cullOccludedGameObjects(FrameInfo& frameInfo, GpuCullSystem& cullSystem) {
+    LVE_PROFILE_FUNCTION();
+    assert(occlusionCulled && "Call cullGameObjects with occlusion first");
+    cullSystem.cull(
+        frameInfo,
+        culledFirstObject,
+        static_cast<uint32_t>(drawList.size()),
+        CullPass::Late,
+        lateCommandOffset,
+        lateInstanceOffset);
+    occlusionCulled = false;
+    lateCulled = true;
+}
 
-        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-        obj.model->bind(frameInfo.commandBuffer);
-        obj.model->draw(frameInfo.commandBuffer);
+void SimpleRenderSystem::recordCulled(FrameInfo& frameInfo, uint32_t groupOffset, bool late) {
+    if (frameInfo.secondaryRecorder) {
+        frameInfo.secondaryRecorder->record(1, [&](VkCommandBuffer commandBuffer, uint32_t) {
+            recordIndirect(frameInfo, commandBuffer, culledFirstObject, true, groupOffset, late);
+        });
+    } else {
+        recordIndirect(frameInfo, frameInfo.commandBuffer, culledFirstObject, true, groupOffset, late);
     }
 }
 
+void SimpleRenderSystem::renderOccludedGameObjects(FrameInfo& frameInfo) {
+    LVE_PROFILE_FUNCTION();
+    if (!lateCulled) return;
+    lateCulled = false;
+    recordCulled(frameInfo, lateGroupOffset, true);
+}
+
+void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo){
+    LVE_PROFILE_FUNCTION();
+    if (culledOnGpu) {
+        culledOnGpu = false;
+        recordCulled(frameInfo, 0, false);
+        return;
+    }
+    // without the gpu cull pass the cpu leaves out what is outside the view
+    buildBatches(frameInfo, true);
+    uint32_t firstObject = frameInfo.objectBuffer.allocate(static_cast<uint32_t>(drawList.size()));
+    updateTransforms(frameInfo, firstObject);
+
+    if (frameInfo.indirectBuffer) {
+        // recording no longer depends on the object count, a single secondary is enough
+        writeObjects(frameInfo, firstObject, 0, drawList.size());
+        buildIndirectCommands(frameInfo, firstObject);
+        if (frameInfo.secondaryRecorder) {
+            frameInfo.secondaryRecorder->record(1, [&](VkCommandBuffer commandBuffer, uint32_t) {
+                recordIndirect(frameInfo, commandBuffer, firstObject);
+            });
+        } else {
+            recordIndirect(frameInfo, frameInfo.commandBuffer, firstObject);
+        }
+    } else if (frameInfo.secondaryRecorder) {
+        renderGameObjectsParallel(frameInfo, firstObject);
+    } else {
+        LveGpuZone gpuZone{frameInfo.gpuProfiler, frameInfo.commandBuffer, "simple render system"};
+        bindFrameState(frameInfo, frameInfo.commandBuffer);
+        recordRange(frameInfo, frameInfo.commandBuffer, firstObject, 0, drawList.size());
+    }
+    frameInfo.objectBuffer.flush();
+}
+
+void SimpleRenderSystem::buildIndirectCommands(FrameInfo& frameInfo, uint32_t firstObject) {
+    auto &indirectBuffer = *frameInfo.indirectBuffer;
+    // at most one command and one group per batch
+    uint32_t batchCount = static_cast<uint32_t>(sortedBatches.size());
+    indirectBuffer.beginFrame(frameInfo.frameIndex, batchCount, batchCount);
+    indirectGroups.clear();
+    directBatches.clear();
+
+    // batches are sorted by vertex buffer, so every page is one contiguous group
+    VkBuffer groupVertexBuffer = VK_NULL_HANDLE;
+    for (auto *batch: sortedBatches) {
+        LveModel *model = batch->model;
+        if (!model->isPooled() || !model->hasIndices()) {
+            directBatches.push_back(batch);
+            continue;
+        }
+        if (model->getVertexBuffer() != groupVertexBuffer) {
+            indirectGroups.push_back({model, indirectBuffer.beginGroup()});
+            groupVertexBuffer = model->getVertexBuffer();
+        }
+        const auto &range = model->getMeshRange();
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = range.indexCount;
+        command.instanceCount = static_cast<uint32_t>(batch->count);
+        command.firstIndex = range.firstIndex;
+        command.vertexOffset = range.vertexOffset;
+        command.firstInstance = firstObject + static_cast<uint32_t>(batch->first);
+        indirectBuffer.add(command);
+    }
+    indirectBuffer.flush();
+}
+
+void SimpleRenderSystem::buildCulledCommands(FrameInfo& frameInfo, GpuCullSystem& cullSystem, bool occlusion) {
+    auto &indirectBuffer = *frameInfo.indirectBuffer;
+    // a command per batch, the late pass gets its own copy of every command and group
+    uint32_t passCount = occlusion ? 2 : 1;
+    uint32_t batchCount = static_cast<uint32_t>(sortedBatches.size());
+    indirectBuffer.beginFrame(frameInfo.frameIndex, passCount * batchCount, passCount * batchCount);
+    // visibility is kept per entity slot across frames
+    uint32_t visibilityCount = 0;
+    for (const auto &obj: drawList) visibilityCount = std::max(visibilityCount, obj.entity.index + 1);
+    cullSystem.beginFrame(frameInfo.frameIndex, static_cast<uint32_t>(sortedBatches.size()), visibilityCount);
+    if (visibilityGenerations.size() < visibilityCount) visibilityGenerations.resize(visibilityCount, ~0u);
+    for (const auto &obj: drawList) {
+        uint32_t &generation = visibilityGenerations[obj.entity.index];
+        if (generation != obj.entity.generation) {
+            cullSystem.resetVisibility(obj.entity.index);
+            generation = obj.entity.generation;
+        }
+    }
+    indirectGroups.clear();
+    directBatches.clear();
+
+    // every batch gets one instanced command with no instances yet and an instance range as large
+    // as the batch. The cull pass packs the visible objects at the front of the range and raises
+    // the command's instanceCount
+    uint32_t instanceCount = static_cast<uint32_t>(drawList.size());
+    uint32_t firstInstance = frameInfo.objectBuffer.allocateInstances(passCount * instanceCount);
+    auto addCommands = [&](uint32_t instanceOffset, bool late) {
+        VkBuffer groupVertexBuffer = VK_NULL_HANDLE;
+        for (auto *batch: sortedBatches) {
+            LveModel *model = batch->model;
+            if (!model->isPooled() || !model->hasIndices()) {
+                if (!late) directBatches.push_back(batch);
+                continue;
+            }
+            if (model->getVertexBuffer() != groupVertexBuffer) {
+                uint32_t group = indirectBuffer.beginGroup();
+                if (!late) indirectGroups.push_back({model, group});
+                groupVertexBuffer = model->getVertexBuffer();
+            }
+            const auto &range = model->getMeshRange();
+            VkDrawIndexedIndirectCommand command{};
+            command.indexCount = range.indexCount;
+            command.instanceCount = 0;
+            command.firstIndex = range.firstIndex;
+            command.vertexOffset = range.vertexOffset;
+            command.firstInstance = firstInstance + instanceOffset + static_cast<uint32_t>(batch->first);
+            CullDraw draw{};
+            draw.command = indirectBuffer.getCommandCount();
+            draw.firstInstance = firstInstance + static_cast<uint32_t>(batch->first);
+            indirectBuffer.add(command);
+            if (!late) batch->drawIndex = cullSystem.addDraw(draw);
+        }
+    };
+    addCommands(0, false);
+    if (occlusion) {
+        // the late pass fills the same layout behind the first one, its groups, commands and
+        // instances are found by adding the offsets to the early ones
+        lateCommandOffset = indirectBuffer.getCommandCount();
+        lateGroupOffset = indirectBuffer.getGroupCount();
+        lateInstanceOffset = instanceCount;
+        addCommands(lateInstanceOffset, true);
+    }
+    indirectBuffer.flush();
+}
+
+void SimpleRenderSystem::recordIndirect(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstObject, bool culled, uint32_t groupOffset, bool late) {
+    LveGpuZone gpuZone{frameInfo.gpuProfiler, commandBuffer, late ? "simple render system late" : "simple render system"};
+    bindFrameState(frameInfo, commandBuffer, culled);
+    for (auto &group: indirectGroups) {
+        group.model->bind(commandBuffer);
+        frameInfo.indirectBuffer->draw(commandBuffer, group.group + groupOffset);
+    }
+    if (late) return;
+    // the direct batches select their objects with firstInstance, the sets stay bound
+    if (culled && !directBatches.empty()) lvePipeline->bind(commandBuffer);
+    for (auto *batch: directBatches) {
+        batch->model->bind(commandBuffer);
+        batch->model->draw(commandBuffer, firstObject + static_cast<uint32_t>(batch->first), static_cast<uint32_t>(batch->count));
+    }
+}
+
+void SimpleRenderSystem::renderGameObjectsParallel(FrameInfo& frameInfo, uint32_t firstObject) {
+    auto &recorder = *frameInfo.secondaryRecorder;
+    size_t jobCount = std::min<size_t>(recorder.getThreadCount(), (drawList.size() + MIN_DRAWS_PER_JOB - 1) / MIN_DRAWS_PER_JOB);
+
+    // the profiler is not thread safe, the zone gets two tiny secondaries of its own around the jobs
+    uint32_t gpuZone = UINT32_MAX;
+    recorder.record(1, [&](VkCommandBuffer commandBuffer, uint32_t) {
+        gpuZone = frameInfo.gpuProfiler.beginZone(commandBuffer, "simple render system");
+    });
+    // every job writes its own slice of the object buffer, no locking while recording
+    recorder.record(static_cast<uint32_t>(jobCount), [&](VkCommandBuffer commandBuffer, uint32_t job) {
+        bindFrameState(frameInfo, commandBuffer);
+        recordRange(frameInfo, commandBuffer, firstObject, drawList.size() * job / jobCount, drawList.size() * (job + 1) / jobCount);
+    });
+    recorder.record(1, [&](VkCommandBuffer commandBuffer, uint32_t) {
+        frameInfo.gpuProfiler.endZone(commandBuffer, gpuZone);
+    });
+}
+
 
 } // namespace lve
@@ -5,10 +5,14 @@
 #include "lve_pipeline.hpp"
 #include "lve_game_object.hpp"
 #include "lve_frame_info.hpp"
+#include "gpu_cull_system.hpp"
+#include "lve_frustum_culler.hpp"
+#include "lve_transform_system.hpp"
 
 
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 
@@ -19,21 +23,123 @@ namespace lve {
 
     class SimpleRenderSystem {
         public:
-        SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout);
         ~SimpleRenderSystem();
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
+        // builds this frame's draws and lets the compute pass pick the visible ones, records the
+        // dispatch outside the render pass. renderGameObjects then only issues the indirect draws.
+        // With occlusion this is the early pass: only objects visible last frame are drawn, the
+        // rest waits for cullOccludedGameObjects
+        void cullGameObjects(FrameInfo& frameInfo, GpuCullSystem& cullSystem, bool occlusion = false);
         void renderGameObjects(FrameInfo& frameInfo);
+        // the late pass, once the depth of the early draws is in the cull system's Hi-Z input.
+        // Records outside the render pass, renderOccludedGameObjects then draws what it found
+        void cullOccludedGameObjects(FrameInfo& frameInfo, GpuCullSystem& cullSystem);
+        void renderOccludedGameObjects(FrameInfo& frameInfo);
     
     private:
+        // objects below this per job are not worth another secondary command buffer
+        static constexpr size_t MIN_DRAWS_PER_JOB = 256;
 
-        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        // an entity drawn this frame, the components stay in the world's chunks for the whole frame
+        struct DrawObject {
+            TransformComponent* transform;
+            const MeshComponent* mesh;
+            // its index is the object's visibility slot, stable while the entity lives
+            LveEntity entity;
+        };
+
+        // objects sharing a model, drawn with one instanced draw
+        struct Batch {
+            LveModel* model = nullptr;
+            std::vector<DrawObject> objects;
+            // range in drawList
+            size_t first = 0;
+            size_t count = 0;
+            // ObjectData::drawIndex of its objects, set when the batch is culled on the gpu
+            uint32_t drawIndex = ObjectData::NO_DRAW;
+        };
+
+        // fills drawList with every entity that has a mesh grouped by model, the groups ordered by
+        // vertex buffer. With frustumCull only the objects whose bounding sphere is in view
+        void buildBatches(FrameInfo& frameInfo, bool frustumCull = false);
+        // the batch holding drawList[index]
+        std::vector<Batch*>::iterator batchAt(size_t index);
+        // writes the objects drawList[begin, end) and draws them, one draw per batch in the range
+        void recordRange(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstObject, size_t begin, size_t end);
+        // brings the matrices of drawList's slots up to date, only the slots whose entity or
+        // transform changed since they were last written are computed again
+        void updateTransforms(FrameInfo& frameInfo, uint32_t firstObject);
+        // everything but the matrices, updateTransforms wrote those
+        void writeObjects(FrameInfo& frameInfo, uint32_t firstObject, size_t begin, size_t end);
+        void renderGameObjectsParallel(FrameInfo& frameInfo, uint32_t firstObject);
+        // one indirect command per batch of pooled indexed models, one indirect draw per mesh page
+        void buildIndirectCommands(FrameInfo& frameInfo, uint32_t firstObject);
+        // like buildIndirectCommands, but the commands start with no instances and the cull pass
+        // adds the visible objects through the instance table. With occlusion the same layout is
+        // written a second time for the late pass
+        void buildCulledCommands(FrameInfo& frameInfo, GpuCullSystem& cullSystem, bool occlusion);
+        // culled draws go through culledPipeline. The late pass draws the groups groupOffset behind
+        // the early ones and leaves out the batches that are not culled, they were drawn by the
+        // early pass
+        void recordIndirect(
+            FrameInfo& frameInfo,
+            VkCommandBuffer commandBuffer,
+            uint32_t firstObject,
+            bool culled = false,
+            uint32_t groupOffset = 0,
+            bool late = false);
+        void recordCulled(FrameInfo& frameInfo, uint32_t groupOffset, bool late);
+        void bindFrameState(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, bool culled = false);
+
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout);
         void createPipeline(VkRenderPass renderPass);
 
         LveDevice &lveDevice;
         
         std::unique_ptr<LvePipeline>lvePipeline;
+        // the same shaders, reading the object of each instance from the instance table
+        std::unique_ptr<LvePipeline> culledPipeline;
         VkPipelineLayout pipelineLayout;
+        // kept across frames so the per model vectors keep their capacity
+        std::unordered_map<LveModel*, Batch> batches;
+        std::vector<Batch*> sortedBatches;
+        struct IndirectGroup {
+            // any model of the group, they all bind the same page
+            LveModel* model;
+            uint32_t group;
+        };
+        std::vector<IndirectGroup> indirectGroups;
+        // models that cannot be drawn indirectly (own buffers or no indices), drawn one by one
+        std::vector<Batch*> directBatches;
+        // objects drawn this frame in batch order, filled on the calling thread and split across the jobs
+        std::vector<DrawObject> drawList;
+        // world space bounds of the entities with a mesh, culled on the cpu when the gpu does not cull
+        std::vector<DrawObject> cullCandidates;
+        LveBoundsTable cullBounds;
+        std::vector<uint32_t> visibleCandidates;
+        // cullGameObjects prepared this frame's draws, renderGameObjects only records them
+        bool culledOnGpu = false;
+        uint32_t culledFirstObject = 0;
+        // where the late pass fills its copy of the commands and instance ranges, see
+        // cullOccludedGameObjects
+        bool occlusionCulled = false;
+        bool lateCulled = false;
+        uint32_t lateCommandOffset = 0;
+        uint32_t lateGroupOffset = 0;
+        uint32_t lateInstanceOffset = 0;
+        // per visibility slot, the generation of the entity that last used it. A new entity in a
+        // reused slot starts hidden instead of inheriting the old one's visibility
+        std::vector<uint32_t> visibilityGenerations;
+        // the matrices of drawList, transform i is object firstObject + i
+        LveTransformSystem transforms{1};
+        // what transform i was last set from
+        struct TransformSlot {
+            LveEntity entity;
+            uint32_t version;
+        };
+        std::vector<TransformSlot> transformSlots;
     
     };
 }
\ No newline at end of file